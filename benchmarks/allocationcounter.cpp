@@ -0,0 +1,92 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <atomic>
+#include <cstdlib>
+#include "allocationcounter.h"
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+}
+
+namespace
+{
+// Plain atomics, a Qt type could allocate while being set up
+std::atomic<qint64> _allocations(0);
+std::atomic<qint64> _bytes(0);
+
+inline void count(size_t size)
+{
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    _bytes.fetch_add(qint64(size), std::memory_order_relaxed);
+}
+}
+
+// Every library of the process resolves these to the executable first, the declarations of stdlib.h are matched
+extern "C" {
+void *malloc(size_t size) __THROW
+{
+    count(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    ::count(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) __THROW
+{
+    count(size);
+    return __libc_realloc(pointer, size);
+}
+}
+
+bool AllocationCounter::isAvailable()
+{
+    return true;
+}
+
+AllocationCounter::Counts AllocationCounter::counts()
+{
+    Counts counts;
+    counts.allocations = _allocations.load(std::memory_order_relaxed);
+    counts.bytes = _bytes.load(std::memory_order_relaxed);
+    return counts;
+}
+
+#else
+
+bool AllocationCounter::isAvailable()
+{
+    return false;
+}
+
+AllocationCounter::Counts AllocationCounter::counts()
+{
+    return Counts();
+}
+
+#endif
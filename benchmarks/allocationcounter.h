@@ -0,0 +1,37 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QtGlobal>
+
+// Counts the heap allocations of the whole process, Qt containers included.
+// Only available with glibc, where malloc can be interposed by the executable.
+namespace AllocationCounter
+{
+struct Counts {
+    // malloc, calloc and realloc calls, and the bytes they asked for
+    qint64 allocations = 0;
+    qint64 bytes = 0;
+};
+
+bool isAvailable();
+Counts counts();
+}
@@ -0,0 +1,313 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QSaveFile>
+#include "gcodegenerator.h"
+
+namespace
+{
+const int _bufferSize = 1024 * 1024;
+const double _pi = 3.14159265358979323846;
+const double _layerHeight = 0.2;
+// Filament per mm of extruded line, for a 0.45 mm line of a 1.75 mm filament
+const double _filamentPerMm = 0.033;
+
+// Formats lines straight into a buffer, QString::arg() would take longer than the parser
+class Writer
+{
+public:
+    explicit Writer(QIODevice &device, qint64 moveCount) :
+        _device(device)
+        , _remaining(moveCount)
+        , _ok(true)
+    {
+        _buffer.reserve(_bufferSize + 256);
+    }
+
+    Writer &operator<<(const char *text)
+    {
+        _buffer.append(text);
+        return *this;
+    }
+
+    Writer &operator<<(qint64 value)
+    {
+        number(value, 0);
+        return *this;
+    }
+
+    // Appends " <letter><value>" with a fixed number of decimals
+    Writer &word(char letter, double value, int decimals)
+    {
+        static const qint64 scale[] = {1, 10, 100, 1000, 10000, 100000};
+        _buffer.append(' ');
+        _buffer.append(letter);
+        number(qRound64(value * scale[decimals]), decimals);
+        return *this;
+    }
+
+    void endLine()
+    {
+        _buffer.append('\n');
+        if (_buffer.size() >= _bufferSize) {
+            flush();
+        }
+    }
+
+    // Starts a G0/G1/G2/G3 line, false once every move is written
+    bool move(const char *command)
+    {
+        if (_remaining <= 0) {
+            return false;
+        }
+        --_remaining;
+        _buffer.append(command);
+        return true;
+    }
+
+    bool done() const
+    {
+        return _remaining <= 0;
+    }
+
+    bool flush()
+    {
+        if (_ok && !_buffer.isEmpty()) {
+            _ok = _device.write(_buffer) == _buffer.size();
+        }
+        _buffer.clear();
+        return _ok;
+    }
+
+private:
+    void number(qint64 fixed, int decimals)
+    {
+        char digits[32];
+        int count = 0;
+        const bool negative = fixed < 0;
+        fixed = qAbs(fixed);
+        for (int i = 0; i < decimals; ++i) {
+            digits[count++] = char('0' + fixed % 10);
+            fixed /= 10;
+        }
+        if (decimals) {
+            digits[count++] = '.';
+        }
+        do {
+            digits[count++] = char('0' + fixed % 10);
+            fixed /= 10;
+        } while (fixed);
+        if (negative) {
+            digits[count++] = '-';
+        }
+        while (count) {
+            _buffer.append(digits[--count]);
+        }
+    }
+
+    QIODevice &_device;
+    QByteArray _buffer;
+    qint64 _remaining;
+    bool _ok;
+};
+
+void denseInfill(Writer &out)
+{
+    const double low = 50;
+    const double high = 150;
+    const double spacing = 0.45;
+    double e = 0;
+    auto extrude = [&out, &e](double x, double y, double length) {
+        e += length * _filamentPerMm;
+        out.word('X', x, 3).word('Y', y, 3).word('E', e, 5).endLine();
+    };
+
+    for (qint64 layer = 0; !out.done(); ++layer) {
+        out << ";LAYER:" << layer;
+        out.endLine();
+        if (out.move("G1")) {
+            out.word('Z', (layer + 1) * _layerHeight, 3).word('F', 600, 0).endLine();
+        }
+        if (out.move("G0")) {
+            out.word('F', 7800, 0).word('X', low, 3).word('Y', low, 3).endLine();
+        }
+
+        out << ";TYPE:WALL-OUTER";
+        out.endLine();
+        const double corners[4][2] = {{high, low}, {high, high}, {low, high}, {low, low}};
+        for (int i = 0; i < 4 && out.move("G1"); ++i) {
+            if (i == 0) {
+                out.word('F', 1800, 0);
+            }
+            extrude(corners[i][0], corners[i][1], high - low);
+        }
+
+        // Zig-zag, every line and every step between two lines is a move
+        out << ";TYPE:FILL";
+        out.endLine();
+        double y = low + spacing;
+        for (double x = low + spacing; x < high - spacing && !out.done(); x += spacing) {
+            if (out.move("G1")) {
+                extrude(x, y, spacing);
+            }
+            y = y > (low + high) / 2 ? low + spacing : high - spacing;
+            if (out.move("G1")) {
+                extrude(x, y, high - low - 2 * spacing);
+            }
+        }
+
+        // Retraction and travel to the next layer
+        if (out.move("G1")) {
+            out.word('F', 2400, 0).word('E', e - 1, 5).endLine();
+        }
+        if (out.move("G1")) {
+            out.word('E', e, 5).endLine();
+        }
+    }
+}
+
+void spiralVase(Writer &out)
+{
+    const int segments = 256;
+    const double centerX = 100;
+    const double centerY = 100;
+    const double radius = 40;
+    const double segmentLength = 2 * _pi * radius / segments;
+    double e = 0;
+
+    if (out.move("G0")) {
+        out.word('F', 7800, 0).word('X', centerX + radius, 3).word('Y', centerY, 3).word('Z', _layerHeight, 3).endLine();
+    }
+    out << ";TYPE:WALL-OUTER";
+    out.endLine();
+    for (qint64 i = 1; out.move("G1"); ++i) {
+        const double angle = 2 * _pi * (i % segments) / segments;
+        e += segmentLength * _filamentPerMm;
+        if (i == 1) {
+            out.word('F', 1200, 0);
+        }
+        out.word('X', centerX + radius * std::cos(angle), 3).word('Y', centerY + radius * std::sin(angle), 3)
+        .word('Z', _layerHeight + _layerHeight * i / segments, 3).word('E', e, 5).endLine();
+    }
+}
+
+void arcHeavy(Writer &out)
+{
+    const double low = 20;
+    const double high = 180;
+    const double radius = 3;
+    const double rowSpacing = 8;
+    double e = 0;
+
+    for (qint64 layer = 0; !out.done(); ++layer) {
+        out << ";LAYER:" << layer;
+        out.endLine();
+        if (out.move("G1")) {
+            out.word('Z', (layer + 1) * _layerHeight, 3).word('F', 600, 0).endLine();
+        }
+        out << ";TYPE:FILL";
+        out.endLine();
+        for (double y = low; y <= high && !out.done(); y += rowSpacing) {
+            if (out.move("G0")) {
+                out.word('F', 7800, 0).word('X', low, 3).word('Y', y, 3).endLine();
+            }
+            // Half circles going up and down the row
+            bool clockwise = true;
+            for (double x = low; x + 2 * radius <= high && out.move(clockwise ? "G2" : "G3"); x += 2 * radius) {
+                e += _pi * radius * _filamentPerMm;
+                out.word('X', x + 2 * radius, 3).word('Y', y, 3).word('I', radius, 3).word('J', 0, 3).word('E', e, 5);
+                if (x == low) {
+                    out.word('F', 1800, 0);
+                }
+                out.endLine();
+                clockwise = !clockwise;
+            }
+        }
+    }
+}
+}
+
+QString GCodeGenerator::name(Kind kind)
+{
+    switch (kind) {
+    case DenseInfill:
+        return QStringLiteral("dense-infill");
+    case SpiralVase:
+        return QStringLiteral("spiral-vase");
+    case ArcHeavy:
+        return QStringLiteral("arc-heavy");
+    default:
+        return QString();
+    }
+}
+
+GCodeGenerator::Kind GCodeGenerator::kind(const QString &name)
+{
+    for (int kind = 0; kind < KindCount; ++kind) {
+        if (GCodeGenerator::name(Kind(kind)) == name) {
+            return Kind(kind);
+        }
+    }
+    return KindCount;
+}
+
+bool GCodeGenerator::write(Kind kind, qint64 moveCount, QIODevice &device)
+{
+    Writer out(device, moveCount);
+    out << "; " << name(kind).toLatin1().constData() << ", " << moveCount << " moves\n"
+        << "G21\nG90\nM82\nM104 S200\nG28\nG92 E0\n";
+
+    switch (kind) {
+    case DenseInfill:
+        denseInfill(out);
+        break;
+    case SpiralVase:
+        spiralVase(out);
+        break;
+    case ArcHeavy:
+        arcHeavy(out);
+        break;
+    default:
+        return false;
+    }
+
+    out << "M104 S0\nM84\n";
+    return out.flush();
+}
+
+QString GCodeGenerator::file(Kind kind, qint64 moveCount, const QString &directory)
+{
+    const QString path = directory + QStringLiteral("/%1-%2.gcode").arg(name(kind)).arg(moveCount);
+    if (QFileInfo::exists(path)) {
+        return path;
+    }
+
+    QDir().mkpath(directory);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !write(kind, moveCount, file) || !file.commit()) {
+        return QString();
+    }
+    return path;
+}
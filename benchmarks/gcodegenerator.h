@@ -0,0 +1,50 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QString>
+
+class QIODevice;
+
+// Synthetic slicer like G-code for the benchmarks.
+// The output only depends on the kind and the move count, so files never need to be shipped.
+class GCodeGenerator
+{
+public:
+    enum Kind {
+        // Layers of perimeters and short zig-zag infill lines
+        DenseInfill = 0,
+        // A single continuous move rising with every segment
+        SpiralVase,
+        // Rows of G2/G3 half circles, most vertices come from the arc tessellation
+        ArcHeavy,
+        KindCount
+    };
+
+    static QString name(Kind kind);
+    // Kind from its name, KindCount when there is none
+    static Kind kind(const QString &name);
+
+    // Writes moveCount G0/G1/G2/G3 lines and the few lines a slicer puts around them
+    static bool write(Kind kind, qint64 moveCount, QIODevice &device);
+    // Path of the generated file in directory, written on the first call only
+    static QString file(Kind kind, qint64 moveCount, const QString &directory);
+};
@@ -0,0 +1,129 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+#include "scankernels.h"
+
+// Throughput of every scanning kernel level supported by this machine, in MB/s of G-code.
+// Usage: kernelbenchmark [size in MB]
+
+namespace
+{
+const int _rounds = 5;
+
+// Slicer like G-code, always the same for a given size
+QByteArray sampleGCode(int size)
+{
+    QByteArray data;
+    data.reserve(size + 128);
+    quint32 seed = 42;
+    auto next = [&seed](int max) {
+        seed = seed * 1664525u + 1013904223u;
+        return int((seed >> 8) % max);
+    };
+    double e = 0;
+    while (data.size() < size) {
+        switch (next(10)) {
+        case 0:
+            data.append(";TYPE:WALL-OUTER\n");
+            break;
+        case 1:
+            data.append(QStringLiteral("G0 F7800 X%1 Y%2\n").arg(next(200000) / 1000.0, 0, 'f', 3).arg(next(200000) / 1000.0, 0, 'f', 3).toLatin1());
+            break;
+        default:
+            e += next(1000) / 10000.0;
+            data.append(QStringLiteral("G1 X%1 Y%2 E%3 ; move\n").arg(next(200000) / 1000.0, 0, 'f', 3).arg(next(200000) / 1000.0, 0, 'f', 3).arg(e, 0, 'f', 5).toLatin1());
+            break;
+        }
+    }
+    return data;
+}
+
+// Best time of a few rounds in ns
+template<typename F> qint64 measure(F function)
+{
+    qint64 best = -1;
+    for (int i = 0; i < _rounds; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        function();
+        const qint64 elapsed = timer.nsecsElapsed();
+        best = best < 0 ? elapsed : qMin(best, elapsed);
+    }
+    return qMax<qint64>(best, 1);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    const int megabytes = argc > 1 ? QByteArray(argv[1]).toInt() : 64;
+    const QByteArray data = sampleGCode(qMax(megabytes, 1) * 1024 * 1024);
+    const char *begin = data.constData();
+    const char *end = begin + data.size();
+
+    // Every number start, the parse kernel is timed without the line scanning
+    QVector<int> numbers;
+    for (int i = 0; i + 1 < data.size(); i++) {
+        if ((data[i] == 'X' || data[i] == 'Y' || data[i] == 'E' || data[i] == 'F') && data[i + 1] != 'T') {
+            numbers.append(i + 1);
+        }
+    }
+
+    QTextStream out(stdout);
+    out << "G-code sample: " << data.size() / (1024 * 1024) << " MB, " << numbers.size() << " numbers\n";
+    out << "Best supported level: " << ScanKernels::kernels().name << "\n";
+
+    volatile quintptr sink = 0;
+    for (int level = ScanKernels::Scalar; level <= ScanKernels::bestLevel(); level++) {
+        const ScanKernels::Kernels &kernels = ScanKernels::kernels(ScanKernels::Level(level));
+
+        const qint64 lineEnd = measure([&] {
+            for (const char *p = begin; p < end; p = kernels.findLineEnd(p, end) + 1) {
+                sink = sink + quintptr(p);
+            }
+        });
+        const qint64 lineEndOrComment = measure([&] {
+            for (const char *p = begin; p < end; p = kernels.findLineEndOrComment(p, end) + 1) {
+                sink = sink + quintptr(p);
+            }
+        });
+        const qint64 parseNumber = measure([&] {
+            float value;
+            for (int offset : numbers) {
+                const char *p = begin + offset;
+                kernels.parseNumber(p, end, value);
+                sink = sink + quintptr(value);
+            }
+        });
+
+        auto megabytesPerSecond = [&data](qint64 ns) {
+            return QString::number(data.size() * 1000.0 / ns / 1.048576, 'f', 0);
+        };
+        out << kernels.name << ":\n";
+        out << "  findLineEnd          " << megabytesPerSecond(lineEnd) << " MB/s\n";
+        out << "  findLineEndOrComment " << megabytesPerSecond(lineEndOrComment) << " MB/s\n";
+        out << "  parseNumber          " << megabytesPerSecond(parseNumber) << " MB/s ("
+            << QString::number(numbers.size() * 1000.0 / parseNumber, 'f', 1) << " M numbers/s)\n";
+    }
+    return 0;
+}
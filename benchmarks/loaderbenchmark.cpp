@@ -0,0 +1,200 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QByteArray>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QList>
+#include <QNode>
+#include <QTextStream>
+#include <QVector>
+#include "allocationcounter.h"
+#include "fileloader.h"
+#include "gcodegenerator.h"
+#include "geometrycache.h"
+#include "linemeshgeometry.h"
+#include "vertexbatch.h"
+
+// FileLoader parsing throughput and LineMeshGeometry vertex buffer construction,
+// over generated files of every kind at several sizes. The geometry cache is disabled.
+// Fails when FileLoader parses any file slower than the minimum throughput.
+// Usage: loaderbenchmark [--huge] [--rounds n] [--kind name] [--directory path] [--minimum MB/s]
+
+namespace
+{
+const qint64 _sizes[] = {100 * 1000, 1000 * 1000, 10 * 1000 * 1000};
+const qint64 _hugeSize = 100 * 1000 * 1000;
+// Batches and their packed copy are kept in memory at once
+const qint64 _maxGeometryVertices = 50 * 1000 * 1000;
+
+struct Measure {
+    // Best round
+    qint64 ns = -1;
+    AllocationCounter::Counts allocations;
+};
+
+// Best time of a few rounds, allocations of the last one
+template<typename F> Measure measure(int rounds, F function)
+{
+    Measure result;
+    for (int i = 0; i < rounds; i++) {
+        const AllocationCounter::Counts before = AllocationCounter::counts();
+        QElapsedTimer timer;
+        timer.start();
+        function();
+        const qint64 elapsed = qMax<qint64>(timer.nsecsElapsed(), 1);
+        const AllocationCounter::Counts after = AllocationCounter::counts();
+        result.ns = result.ns < 0 ? elapsed : qMin(result.ns, elapsed);
+        result.allocations.allocations = after.allocations - before.allocations;
+        result.allocations.bytes = after.bytes - before.bytes;
+    }
+    return result;
+}
+
+// Runs a whole load on this thread, batches are kept when asked for
+qint64 load(const QString &path, QList<VertexBatch> *batches = nullptr)
+{
+    QString fileName = path;
+    FileLoader loader(fileName);
+    qint64 vertexCount = 0;
+    QObject::connect(&loader, &FileLoader::posBatch, [&vertexCount, batches](const VertexBatch & batch) {
+        // Without the vertex repeated from the previous batch
+        vertexCount += batch.vertices.size() / sizeof(VertexBatch::Vertex) - (vertexCount > 0 ? 1 : 0);
+        if (batches) {
+            batches->append(batch);
+        }
+    });
+    loader.run();
+    return vertexCount;
+}
+
+QString allocations(const AllocationCounter::Counts &counts)
+{
+    if (!AllocationCounter::isAvailable()) {
+        return QString();
+    }
+    return QStringLiteral("  %1 allocations (%2 MB)").arg(counts.allocations).arg(counts.bytes / 1048576.0, 0, 'f', 1);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption hugeOption(QStringLiteral("huge"), QStringLiteral("Also load 10^8 moves files, several GB each"));
+    const QCommandLineOption roundsOption(QStringLiteral("rounds"), QStringLiteral("Rounds per measure, the best one is kept"), QStringLiteral("n"), QStringLiteral("3"));
+    const QCommandLineOption kindOption(QStringLiteral("kind"), QStringLiteral("Only this kind of file: dense-infill, spiral-vase or arc-heavy"), QStringLiteral("name"));
+    const QCommandLineOption directoryOption(QStringLiteral("directory"), QStringLiteral("Where generated files are kept between runs"), QStringLiteral("path"),
+                                             QDir::tempPath() + QStringLiteral("/atelier-benchmarks"));
+    const QCommandLineOption minimumOption(QStringLiteral("minimum"), QStringLiteral("Slowest FileLoader throughput allowed, 0 for none"), QStringLiteral("MB/s"),
+                                           QStringLiteral("0"));
+    parser.addOptions({hugeOption, roundsOption, kindOption, directoryOption, minimumOption});
+    parser.process(app);
+
+    const int rounds = qMax(parser.value(roundsOption).toInt(), 1);
+    const double minimum = parser.value(minimumOption).toDouble();
+    QVector<qint64> sizes;
+    for (qint64 size : _sizes) {
+        sizes.append(size);
+    }
+    if (parser.isSet(hugeOption)) {
+        sizes.append(_hugeSize);
+    }
+    QVector<GCodeGenerator::Kind> kinds;
+    for (int kind = 0; kind < GCodeGenerator::KindCount; kind++) {
+        kinds.append(GCodeGenerator::Kind(kind));
+    }
+    if (parser.isSet(kindOption)) {
+        const GCodeGenerator::Kind kind = GCodeGenerator::kind(parser.value(kindOption));
+        if (kind == GCodeGenerator::KindCount) {
+            parser.showHelp(1);
+        }
+        kinds = {kind};
+    }
+
+    GeometryCache::setEnabled(false);
+    QTextStream out(stdout);
+    if (!AllocationCounter::isAvailable()) {
+        out << "Allocations are not counted on this platform\n";
+    }
+    bool failed = false;
+
+    for (GCodeGenerator::Kind kind : kinds) {
+        for (qint64 size : sizes) {
+            const QString path = GCodeGenerator::file(kind, size, parser.value(directoryOption));
+            if (path.isEmpty()) {
+                out << "Could not write the " << GCodeGenerator::name(kind) << " file in " << parser.value(directoryOption) << "\n";
+                return 1;
+            }
+            const qint64 fileSize = QFileInfo(path).size();
+            out << GCodeGenerator::name(kind) << ", " << size << " moves, "
+                << QString::number(fileSize / 1048576.0, 'f', 1) << " MB:\n";
+            out.flush();
+
+            qint64 vertexCount = 0;
+            const Measure parse = measure(size < _hugeSize ? rounds : 1, [&] {
+                vertexCount = load(path);
+            });
+            const double throughput = fileSize * 1000.0 / parse.ns / 1.048576;
+            out << "  FileLoader               " << QString::number(throughput, 'f', 0) << " MB/s, "
+                << QString::number(size * 1000.0 / parse.ns, 'f', 1) << " M moves/s, "
+                << vertexCount << " vertices" << allocations(parse.allocations) << "\n";
+            if (throughput < minimum) {
+                out << "  regression: below " << minimum << " MB/s\n";
+                failed = true;
+            }
+            out.flush();
+
+            if (vertexCount > _maxGeometryVertices) {
+                continue;
+            }
+            // Same batches as a load, and the same vertices in one array, without their lines
+            QList<VertexBatch> batches;
+            load(path, &batches);
+            QByteArray packed;
+            packed.reserve(int(vertexCount * sizeof(VertexBatch::Vertex)));
+            for (const VertexBatch &batch : batches) {
+                packed.append(batch.vertices);
+            }
+
+            // One geometry per batch, as LineMesh does
+            const Measure fromBatches = measure(rounds, [&batches] {
+                Qt3DCore::QNode root;
+                for (const VertexBatch &batch : batches) {
+                    LineMeshGeometry *geometry = new LineMeshGeometry(batch.vertices, LineMeshGeometry::Toolpath, &root);
+                    geometry->setLines(batch.lines);
+                }
+            });
+            const Measure fromPacked = measure(rounds, [&packed] {
+                LineMeshGeometry geometry(packed, LineMeshGeometry::Toolpath);
+            });
+            out << "  LineMeshGeometry batches " << QString::number(fromBatches.ns / 1e6, 'f', 1) << " ms for "
+                << batches.size() << " batches" << allocations(fromBatches.allocations) << "\n";
+            out << "  LineMeshGeometry packed  " << QString::number(fromPacked.ns / 1e6, 'f', 1) << " ms"
+                << allocations(fromPacked.allocations) << "\n";
+            out.flush();
+        }
+    }
+    return failed ? 1 : 0;
+}
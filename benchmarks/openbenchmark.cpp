@@ -0,0 +1,503 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEntity>
+#include <QFile>
+#include <QFrameAction>
+#include <QHash>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QQuickWindow>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+#include <QVector3D>
+#include "gcodegenerator.h"
+#include "geometrycache.h"
+#include "linemesh.h"
+#include "toolpathmaterial.h"
+#include "viewer3d.h"
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+// Time from opening a file to seeing it, through the same path as MainWindow::loadFile():
+// Viewer3D::drawModel(), the QML fileName item or the SceneWindow, LineMesh::readAndRun(), the loader and the first frames.
+// Then the mean time between frames once the file is drawn. Frames are counted by a FrameAction,
+// which ticks the same way under both backends of Viewer3D.
+// Every file is opened by a child process of its own, rendering offscreen with a software OpenGL,
+// so the peak RSS is the one of that file and that backend only. The geometry cache is disabled.
+// Usage: openbenchmark [--kind name] [--backend quick|window|both] [--huge] [--save results.json] [--baseline results.json --threshold percent]
+// With --schemes, it checks instead that every color scheme of the QML view tells the moves of a small file apart.
+
+namespace
+{
+const qint64 _sizes[] = {100 * 1000, 1000 * 1000, 10 * 1000 * 1000};
+const qint64 _hugeSize = 100 * 1000 * 1000;
+// Stages in the order they happen, ms since drawModel() but for the startup
+const char *const _stages[] = {"startup", "firstVertices", "firstFrame", "parsed", "lastFrame"};
+// Smaller changes are noise whatever the threshold
+const double _minimumRegressionMs = 10;
+const double _minimumFrameRegressionMs = 1;
+// Frames measured once the file is drawn, ms
+const int _steadyDuration = 2000;
+const int _defaultTimeout = 600;
+// In the order of the color scheme combo box
+const char *const _schemes[] = {"feature", "speed", "layer", "flow"};
+const int _schemeLayers = 10;
+// Frames given to a change before the window is grabbed
+const int _settleFrames = 10;
+// Smaller differences from the empty scene are noise
+const int _minimumPixelChange = 48;
+// Colors drawn by fewer of the changed pixels are crossings with the grid
+const double _minimumColorShare = 0.02;
+
+qint64 peakRss()
+{
+#if defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(Q_OS_MAC)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+Viewer3D::Backend backendNamed(const QString &name)
+{
+    return name == QStringLiteral("window") ? Viewer3D::WindowBackend : Viewer3D::QuickBackend;
+}
+
+// Child side, opens a single file and prints its stages as JSON
+int openFile(QApplication &app, const QString &path, Viewer3D::Backend backend, int timeout)
+{
+    GeometryCache::setEnabled(false);
+    QJsonObject result;
+    QElapsedTimer timer;
+    timer.start();
+
+    Viewer3D viewer(backend);
+    viewer.resize(1280, 720);
+    viewer.show();
+
+    LineMesh *lineMesh = viewer.lineMesh();
+    auto sceneRoot = lineMesh ? qobject_cast<Qt3DCore::QEntity *>(lineMesh->parentNode()) : nullptr;
+    if (!sceneRoot) {
+        QTextStream(stderr) << "No LineMesh in the 3D view\n";
+        return 1;
+    }
+
+    // Ticks once per frame of the logic aspect, whatever thread renders it
+    auto frameAction = new Qt3DLogic::QFrameAction(sceneRoot);
+    sceneRoot->addComponent(frameAction);
+    bool opened = false;
+    bool hasVertices = false;
+    bool parsed = false;
+    QElapsedTimer steady;
+    double frameTimes = 0;
+    int frameCount = 0;
+    auto mark = [&result, &timer](const char *stage) {
+        if (!result.contains(QLatin1String(stage))) {
+            result.insert(QLatin1String(stage), timer.nsecsElapsed() / 1e6);
+        }
+    };
+    QObject::connect(frameAction, &Qt3DLogic::QFrameAction::triggered, &app, [&](float dt) {
+        if (!opened) {
+            mark("startup");
+            opened = true;
+            timer.restart();
+            viewer.drawModel(QUrl::fromLocalFile(path).toString());
+        } else if (parsed) {
+            // Small files can be done before any frame shows them
+            mark("firstFrame");
+            mark("lastFrame");
+            // The frame after the last one is the first that only draws
+            if (!steady.isValid()) {
+                steady.start();
+                return;
+            }
+            frameTimes += dt;
+            ++frameCount;
+            if (steady.elapsed() >= _steadyDuration) {
+                app.quit();
+            }
+        } else if (hasVertices) {
+            mark("firstFrame");
+        }
+    }, Qt::QueuedConnection);
+    QObject::connect(lineMesh, &LineMesh::vertexCountChanged, &app, [&](qint64 count) {
+        if (count > 0) {
+            mark("firstVertices");
+            hasVertices = true;
+        }
+    });
+    QObject::connect(lineMesh, &LineMesh::finished, &app, [&] {
+        mark("parsed");
+        parsed = true;
+    });
+    QTimer::singleShot(timeout * 1000, &app, [&app] {
+        QTextStream(stderr) << "Timed out\n";
+        app.exit(1);
+    });
+
+    if (app.exec() != 0) {
+        return 1;
+    }
+    result.insert(QStringLiteral("frameTime"), frameCount ? 1000 * frameTimes / frameCount : 0.0);
+    result.insert(QStringLiteral("vertices"), double(lineMesh->vertexCount()));
+    result.insert(QStringLiteral("peakRss"), double(peakRss()));
+    QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << "\n";
+    return 0;
+}
+
+// Ten layers of an outer wall drawn slowly with a thin line, around support drawn fast with a thick one,
+// so every color scheme has at least two colors
+bool writeSchemeFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    QTextStream out(&file);
+    double x = 0;
+    double y = 0;
+    double e = 0;
+    // flow in mm of filament per mm
+    auto extrude = [&out, &x, &y, &e](double toX, double toY, double flow) {
+        e += flow * std::hypot(toX - x, toY - y);
+        x = toX;
+        y = toY;
+        out << "G1 X" << x << " Y" << y << " E" << QString::number(e, 'f', 5) << "\n";
+    };
+    out << "G21\nG90\nM82\nG92 E0\n";
+    for (int layer = 0; layer < _schemeLayers; ++layer) {
+        out << ";LAYER:" << layer << "\n";
+        out << "G0 F600 Z" << QString::number((layer + 1) * 0.2, 'f', 1) << "\n";
+        out << ";TYPE:WALL-OUTER\n";
+        x = y = 80;
+        out << "G0 F6000 X80 Y80\nG1 F1200\n";
+        extrude(120, 80, 0.03);
+        extrude(120, 120, 0.03);
+        extrude(80, 120, 0.03);
+        extrude(80, 80, 0.03);
+        out << ";TYPE:SUPPORT\n";
+        x = y = 85;
+        out << "G0 X85 Y85\nG1 F6000\n";
+        for (int row = 0; row < 7; ++row) {
+            extrude(row % 2 ? 85 : 115, y, 0.06);
+            if (row < 6) {
+                extrude(x, y + 5, 0.06);
+            }
+        }
+    }
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+// Colors of the pixels that differ from reference. Pixels are counted by their direction from the reference,
+// so the antialiased edges of a line count as the line.
+int colorCount(const QImage &image, const QImage &reference)
+{
+    QHash<int, int> counts;
+    int changed = 0;
+    for (int y = 0; y < image.height() && y < reference.height(); ++y) {
+        const QRgb *pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        const QRgb *referencePixels = reinterpret_cast<const QRgb *>(reference.constScanLine(y));
+        for (int x = 0; x < image.width() && x < reference.width(); ++x) {
+            const QVector3D delta(qRed(pixels[x]) - qRed(referencePixels[x]), qGreen(pixels[x]) - qGreen(referencePixels[x]),
+                                  qBlue(pixels[x]) - qBlue(referencePixels[x]));
+            if (delta.length() < _minimumPixelChange) {
+                continue;
+            }
+            const QVector3D direction = delta.normalized() * 4;
+            ++counts[(qRound(direction.x()) + 4) * 81 + (qRound(direction.y()) + 4) * 9 + qRound(direction.z()) + 4];
+            ++changed;
+        }
+    }
+    int count = 0;
+    for (int pixels : qAsConst(counts)) {
+        if (pixels >= changed * _minimumColorShare) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Draws the scheme file with every color scheme, fails when one of them draws all the moves with the same color
+int checkSchemes(QApplication &app, const QString &directory, int timeout)
+{
+    GeometryCache::setEnabled(false);
+    const QString path = directory + QStringLiteral("/color-schemes.gcode");
+    if (!QDir().mkpath(directory) || !writeSchemeFile(path)) {
+        QTextStream(stderr) << "Could not write " << path << "\n";
+        return 1;
+    }
+
+    Viewer3D viewer(Viewer3D::QuickBackend);
+    viewer.resize(1280, 720);
+    viewer.show();
+
+    LineMesh *lineMesh = viewer.lineMesh();
+    auto sceneRoot = lineMesh ? qobject_cast<Qt3DCore::QEntity *>(lineMesh->parentNode()) : nullptr;
+    auto material = lineMesh ? qobject_cast<ToolpathMaterial *>(lineMesh->material()) : nullptr;
+    QQuickWindow *window = nullptr;
+    for (QWindow *candidate : QGuiApplication::allWindows()) {
+        window = window ? window : qobject_cast<QQuickWindow *>(candidate);
+    }
+    if (!sceneRoot || !material || !window) {
+        QTextStream(stderr) << "No LineMesh with a ToolpathMaterial in the 3D view\n";
+        return 1;
+    }
+
+    auto frameAction = new Qt3DLogic::QFrameAction(sceneRoot);
+    sceneRoot->addComponent(frameAction);
+    bool opened = false;
+    bool parsed = false;
+    int frames = 0;
+    // The scene without the moves first, then every scheme
+    int scheme = -1;
+    QImage reference;
+    int failures = 0;
+    QTextStream out(stdout);
+    QObject::connect(lineMesh, &LineMesh::finished, &app, [&] {
+        lineMesh->setShowTravels(false);
+        lineMesh->setShowExtrusions(false);
+        parsed = true;
+        frames = 0;
+    });
+    QObject::connect(frameAction, &Qt3DLogic::QFrameAction::triggered, &app, [&] {
+        if (!opened) {
+            opened = true;
+            viewer.drawModel(QUrl::fromLocalFile(path).toString());
+            return;
+        }
+        if (!parsed || ++frames < _settleFrames) {
+            return;
+        }
+        frames = 0;
+        const QImage image = window->grabWindow().convertToFormat(QImage::Format_RGB32);
+        if (scheme < 0) {
+            reference = image;
+            lineMesh->setShowExtrusions(true);
+        } else {
+            const int count = colorCount(image, reference);
+            out << _schemes[scheme] << ": " << count << " colors\n";
+            if (count < 2) {
+                out << "  every move is drawn with the same color\n";
+                ++failures;
+            }
+            out.flush();
+        }
+        if (++scheme == int(sizeof(_schemes) / sizeof(_schemes[0]))) {
+            app.quit();
+            return;
+        }
+        material->setColorScheme(QLatin1String(_schemes[scheme]));
+    }, Qt::QueuedConnection);
+    QTimer::singleShot(timeout * 1000, &app, [&app] {
+        QTextStream(stderr) << "Timed out\n";
+        app.exit(1);
+    });
+
+    if (app.exec() != 0) {
+        return 1;
+    }
+    return failures > 0 ? 1 : 0;
+}
+
+// Values of stages that got slower than the baseline
+QStringList regressions(const QJsonObject &result, const QJsonObject &baseline, double threshold)
+{
+    QStringList found;
+    auto check = [&](const QString &key, double slack) {
+        if (!baseline.contains(key) || !result.contains(key)) {
+            return;
+        }
+        const double before = baseline.value(key).toDouble();
+        const double after = result.value(key).toDouble();
+        if (after > before * (1 + threshold / 100) && after - before > slack) {
+            found.append(QStringLiteral("%1 %2 -> %3").arg(key).arg(before, 0, 'f', 1).arg(after, 0, 'f', 1));
+        }
+    };
+    for (const char *stage : _stages) {
+        check(QLatin1String(stage), _minimumRegressionMs);
+    }
+    check(QStringLiteral("frameTime"), _minimumFrameRegressionMs);
+    check(QStringLiteral("peakRss"), 0);
+    return found;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    // Headless unless asked otherwise, Mesa renders on the CPU
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    if (qEnvironmentVariableIsEmpty("LIBGL_ALWAYS_SOFTWARE")) {
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+    }
+    QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption openOption(QStringLiteral("open"), QStringLiteral("Opens a single file in this process"), QStringLiteral("path"));
+    const QCommandLineOption hugeOption(QStringLiteral("huge"), QStringLiteral("Also open 10^8 moves files, several GB each"));
+    const QCommandLineOption backendOption(QStringLiteral("backend"), QStringLiteral("3D view to open the files with: quick, window or both"), QStringLiteral("name"),
+                                           QStringLiteral("quick"));
+    const QCommandLineOption kindOption(QStringLiteral("kind"), QStringLiteral("Only this kind of file: dense-infill, spiral-vase or arc-heavy"), QStringLiteral("name"));
+    const QCommandLineOption directoryOption(QStringLiteral("directory"), QStringLiteral("Where generated files are kept between runs"), QStringLiteral("path"),
+                                             QDir::tempPath() + QStringLiteral("/atelier-benchmarks"));
+    const QCommandLineOption saveOption(QStringLiteral("save"), QStringLiteral("Writes the results, to be used as a baseline later"), QStringLiteral("file"));
+    const QCommandLineOption baselineOption(QStringLiteral("baseline"), QStringLiteral("Fails when a result is worse than in this file"), QStringLiteral("file"));
+    const QCommandLineOption thresholdOption(QStringLiteral("threshold"), QStringLiteral("Allowed regression against the baseline, in percent"), QStringLiteral("percent"), QStringLiteral("20"));
+    const QCommandLineOption timeoutOption(QStringLiteral("timeout"), QStringLiteral("Seconds given to open a file"), QStringLiteral("seconds"), QString::number(_defaultTimeout));
+    const QCommandLineOption schemesOption(QStringLiteral("schemes"), QStringLiteral("Checks that every color scheme draws a small file with several colors"));
+    parser.addOptions({openOption, hugeOption, backendOption, kindOption, directoryOption, saveOption, baselineOption, thresholdOption, timeoutOption,
+                       schemesOption
+                      });
+    parser.process(app);
+
+    const int timeout = qMax(parser.value(timeoutOption).toInt(), 1);
+    if (parser.isSet(openOption)) {
+        return openFile(app, parser.value(openOption), backendNamed(parser.value(backendOption)), timeout);
+    }
+    if (parser.isSet(schemesOption)) {
+        return checkSchemes(app, parser.value(directoryOption), timeout);
+    }
+
+    QJsonObject baseline;
+    if (parser.isSet(baselineOption)) {
+        QFile file(parser.value(baselineOption));
+        if (!file.open(QIODevice::ReadOnly)) {
+            QTextStream(stderr) << "Could not read " << file.fileName() << "\n";
+            return 1;
+        }
+        baseline = QJsonDocument::fromJson(file.readAll()).object();
+    }
+    const double threshold = parser.value(thresholdOption).toDouble();
+
+    QVector<qint64> sizes;
+    for (qint64 size : _sizes) {
+        sizes.append(size);
+    }
+    if (parser.isSet(hugeOption)) {
+        sizes.append(_hugeSize);
+    }
+    QVector<GCodeGenerator::Kind> kinds;
+    for (int kind = 0; kind < GCodeGenerator::KindCount; kind++) {
+        kinds.append(GCodeGenerator::Kind(kind));
+    }
+    if (parser.isSet(kindOption)) {
+        const GCodeGenerator::Kind kind = GCodeGenerator::kind(parser.value(kindOption));
+        if (kind == GCodeGenerator::KindCount) {
+            parser.showHelp(1);
+        }
+        kinds = {kind};
+    }
+    QStringList backends = {parser.value(backendOption)};
+    if (backends.first() == QStringLiteral("both")) {
+        backends = {QStringLiteral("quick"), QStringLiteral("window")};
+    } else if (backends.first() != QStringLiteral("quick") && backends.first() != QStringLiteral("window")) {
+        parser.showHelp(1);
+    }
+
+    QTextStream out(stdout);
+    QJsonObject results;
+    bool failed = false;
+    for (GCodeGenerator::Kind kind : kinds) {
+        for (qint64 size : sizes) {
+            const QString fileName = QStringLiteral("%1-%2").arg(GCodeGenerator::name(kind)).arg(size);
+            const QString path = GCodeGenerator::file(kind, size, parser.value(directoryOption));
+            if (path.isEmpty()) {
+                out << "Could not write " << fileName << " in " << parser.value(directoryOption) << "\n";
+                return 1;
+            }
+
+            QJsonObject quickResult;
+            for (const QString &backendName : backends) {
+                // The QML view keeps the names of the baselines saved before there was a choice
+                const QString name = backendName == QStringLiteral("quick") ? fileName : fileName + QStringLiteral("-") + backendName;
+                QProcess child;
+                child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+                child.start(QCoreApplication::applicationFilePath(), {QStringLiteral("--open"), path, QStringLiteral("--backend"), backendName,
+                                                                      QStringLiteral("--timeout"), QString::number(timeout)
+                                                                     });
+                child.waitForFinished(-1);
+                const QJsonObject result = QJsonDocument::fromJson(child.readAllStandardOutput().trimmed()).object();
+                if (child.exitStatus() != QProcess::NormalExit || child.exitCode() != 0 || result.isEmpty()) {
+                    out << name << ": failed\n";
+                    failed = true;
+                    continue;
+                }
+                results.insert(name, result);
+
+                out << name << ":";
+                for (const char *stage : _stages) {
+                    out << " " << stage << " " << QString::number(result.value(QLatin1String(stage)).toDouble(), 'f', 1) << " ms,";
+                }
+                out << " frame " << QString::number(result.value(QStringLiteral("frameTime")).toDouble(), 'f', 2) << " ms,"
+                    << " peak RSS " << QString::number(result.value(QStringLiteral("peakRss")).toDouble() / 1024, 'f', 1) << " MB\n";
+
+                // Both backends on the same file, relative to the QML view
+                if (backendName == QStringLiteral("quick")) {
+                    quickResult = result;
+                } else if (!quickResult.isEmpty()) {
+                    auto ratio = [&quickResult, &result](const QString &key) {
+                        const double before = quickResult.value(key).toDouble();
+                        return before > 0 ? QStringLiteral("%1%").arg(100 * (result.value(key).toDouble() - before) / before, 0, 'f', 1) : QStringLiteral("-");
+                    };
+                    out << "  against quick: lastFrame " << ratio(QStringLiteral("lastFrame")) << ", frame " << ratio(QStringLiteral("frameTime"))
+                        << ", peak RSS " << ratio(QStringLiteral("peakRss")) << "\n";
+                }
+
+                const QStringList worse = regressions(result, baseline.value(name).toObject(), threshold);
+                for (const QString &regression : worse) {
+                    out << "  regression: " << regression << "\n";
+                }
+                failed = failed || !worse.isEmpty();
+                out.flush();
+            }
+        }
+    }
+
+    if (parser.isSet(saveOption)) {
+        QFile file(parser.value(saveOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(results).toJson()) < 0) {
+            out << "Could not write " << file.fileName() << "\n";
+            return 1;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -20,6 +20,7 @@
 #include <KLocalizedString>
 #include <QDir>
 #include <QMessageBox>
+#include "printtimeestimator.h"
 #include "profilesdialog.h"
 #include "ui_profilesdialog.h"
 
@@ -72,6 +73,20 @@ ProfilesDialog::ProfilesDialog(QWidget *parent) :
     connect(ui->extruderTempSB, &QSpinBox::editingFinished, modify);
     connect(ui->postPauseLE, &QLineEdit::editingFinished, modify);
     connect(ui->firmwareCB, &QComboBox::currentTextChanged, modify);
+    connect(ui->maxFeedRateXYSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->maxFeedRateZSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->maxFeedRateESB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->maxAccelerationXYSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->maxAccelerationZSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->maxAccelerationESB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->printAccelerationSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->travelAccelerationSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->retractAccelerationSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->junctionDeviationSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->jerkXYSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->jerkZSB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->jerkESB, &QDoubleSpinBox::editingFinished, modify);
+    connect(ui->lookaheadSB, &QSpinBox::editingFinished, modify);
 }
 
 ProfilesDialog::~ProfilesDialog()
@@ -145,6 +160,21 @@ void ProfilesDialog::save()
     m_settings.setValue(QStringLiteral("bps"), ui->baudCB->currentText());
     m_settings.setValue(QStringLiteral("firmware"), ui->firmwareCB->currentText());
     m_settings.setValue(QStringLiteral("postPause"), ui->postPauseLE->text());
+    //Motion
+    m_settings.setValue(QStringLiteral("maxFeedRateXY"), ui->maxFeedRateXYSB->value());
+    m_settings.setValue(QStringLiteral("maxFeedRateZ"), ui->maxFeedRateZSB->value());
+    m_settings.setValue(QStringLiteral("maxFeedRateE"), ui->maxFeedRateESB->value());
+    m_settings.setValue(QStringLiteral("maxAccelerationXY"), ui->maxAccelerationXYSB->value());
+    m_settings.setValue(QStringLiteral("maxAccelerationZ"), ui->maxAccelerationZSB->value());
+    m_settings.setValue(QStringLiteral("maxAccelerationE"), ui->maxAccelerationESB->value());
+    m_settings.setValue(QStringLiteral("printAcceleration"), ui->printAccelerationSB->value());
+    m_settings.setValue(QStringLiteral("travelAcceleration"), ui->travelAccelerationSB->value());
+    m_settings.setValue(QStringLiteral("retractAcceleration"), ui->retractAccelerationSB->value());
+    m_settings.setValue(QStringLiteral("junctionDeviation"), ui->junctionDeviationSB->value());
+    m_settings.setValue(QStringLiteral("jerkXY"), ui->jerkXYSB->value());
+    m_settings.setValue(QStringLiteral("jerkZ"), ui->jerkZSB->value());
+    m_settings.setValue(QStringLiteral("jerkE"), ui->jerkESB->value());
+    m_settings.setValue(QStringLiteral("lookahead"), ui->lookaheadSB->value());
     m_settings.endGroup();
     m_settings.endGroup();
 
@@ -188,6 +218,22 @@ void ProfilesDialog::loadSettings(const QString &currentProfile)
     ui->baudCB->setCurrentText(m_settings.value(QStringLiteral("bps"), QStringLiteral("115200")).toString());
     ui->firmwareCB->setCurrentText(m_settings.value(QStringLiteral("firmware"), QStringLiteral("Auto-Detect")).toString());
     ui->postPauseLE->setText(m_settings.value(QStringLiteral("postPause"), QStringLiteral("")).toString());
+    //Motion, defaults for profiles saved before it existed
+    const MotionLimits limits;
+    ui->maxFeedRateXYSB->setValue(m_settings.value(QStringLiteral("maxFeedRateXY"), limits.maxFeedRateXY).toDouble());
+    ui->maxFeedRateZSB->setValue(m_settings.value(QStringLiteral("maxFeedRateZ"), limits.maxFeedRateZ).toDouble());
+    ui->maxFeedRateESB->setValue(m_settings.value(QStringLiteral("maxFeedRateE"), limits.maxFeedRateE).toDouble());
+    ui->maxAccelerationXYSB->setValue(m_settings.value(QStringLiteral("maxAccelerationXY"), limits.maxAccelerationXY).toDouble());
+    ui->maxAccelerationZSB->setValue(m_settings.value(QStringLiteral("maxAccelerationZ"), limits.maxAccelerationZ).toDouble());
+    ui->maxAccelerationESB->setValue(m_settings.value(QStringLiteral("maxAccelerationE"), limits.maxAccelerationE).toDouble());
+    ui->printAccelerationSB->setValue(m_settings.value(QStringLiteral("printAcceleration"), limits.printAcceleration).toDouble());
+    ui->travelAccelerationSB->setValue(m_settings.value(QStringLiteral("travelAcceleration"), limits.travelAcceleration).toDouble());
+    ui->retractAccelerationSB->setValue(m_settings.value(QStringLiteral("retractAcceleration"), limits.retractAcceleration).toDouble());
+    ui->junctionDeviationSB->setValue(m_settings.value(QStringLiteral("junctionDeviation"), limits.junctionDeviation).toDouble());
+    ui->jerkXYSB->setValue(m_settings.value(QStringLiteral("jerkXY"), limits.jerkXY).toDouble());
+    ui->jerkZSB->setValue(m_settings.value(QStringLiteral("jerkZ"), limits.jerkZ).toDouble());
+    ui->jerkESB->setValue(m_settings.value(QStringLiteral("jerkE"), limits.jerkE).toDouble());
+    ui->lookaheadSB->setValue(m_settings.value(QStringLiteral("lookahead"), limits.lookahead).toInt());
     m_settings.endGroup();
     m_settings.endGroup();
     setModified(false);
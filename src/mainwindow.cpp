@@ -165,6 +165,28 @@ void MainWindow::newAtCoreInstance()
     });
 
     connect(newInstanceWidget, &AtCoreInstanceWidget::connectionChanged, this, &MainWindow::atCoreInstanceNameChange);
+    //Estimate print times for the printer connected last
+    connect(newInstanceWidget, &AtCoreInstanceWidget::profileChanged, m_lateral.get<Viewer3D>("3d"), &Viewer3D::setProfile);
+    // The 3D view follows a single print of the drawn file, the one that reported first
+    connect(newInstanceWidget, &AtCoreInstanceWidget::printProgressChanged, this, [this, newInstanceWidget](const QUrl & file, float progress) {
+        Viewer3D *viewer3D = m_lateral.get<Viewer3D>("3d");
+        if (file != viewer3D->drawnFile()) {
+            if (m_printShown == newInstanceWidget) {
+                m_printShown = nullptr;
+            }
+            return;
+        }
+        if (m_printShown && m_printShown != newInstanceWidget) {
+            return;
+        }
+        m_printShown = progress < 0 ? nullptr : newInstanceWidget;
+        viewer3D->setPrintProgress(file, progress);
+    });
+    connect(newInstanceWidget, &AtCoreInstanceWidget::positionReported, this, [this, newInstanceWidget](const QUrl & file, const QVector3D & position) {
+        if (m_printShown == newInstanceWidget) {
+            m_lateral.get<Viewer3D>("3d")->addPrinterPosition(file, position);
+        }
+    });
 
     if (m_instances->count() > 1) {
         m_instances->setTabsClosable(true);
@@ -225,10 +247,19 @@ void MainWindow::setupLateralArea()
 
     auto *viewer3D = new Viewer3D(this);
     connect(viewer3D, &Viewer3D::droppedUrls, this, &MainWindow::processDropEvent);
+    connect(this, &MainWindow::profilesChanged, viewer3D, &Viewer3D::updateMotionLimits);
 
     connect(m_gcodeEditor, &GCodeEditorWidget::currentFileChanged, this, [this, viewer3D](const QUrl & url) {
         viewer3D->drawModel(url.toString());
     });
+    connect(viewer3D, &Viewer3D::lineClicked, this, [this](const QUrl & file, int line) {
+        m_gcodeEditor->goToLine(file, line);
+        // Show the editor, the 3D view is in the same stack
+        m_lateral.getButton<QPushButton>("gcode")->setChecked(true);
+        m_lateral.m_stack->setHidden(false);
+        m_lateral.m_stack->setCurrentWidget(m_gcodeEditor);
+        toggleGCodeActions();
+    });
 
     setupButton("welcome", i18n("&Welcome"), QIcon::fromTheme("go-home", QIcon(QString(":/%1/home").arg(m_theme))), new WelcomeWidget(this));
     setupButton("3d", i18n("&3D"), QIcon::fromTheme("draw-cuboid", QIcon(QString(":/%1/3d").arg(m_theme))), viewer3D);
@@ -266,6 +297,15 @@ void MainWindow::setupActions()
         emit(profilesChanged());
     });
 
+    action = actionCollection()->addAction(QStringLiteral("native_3d_view"));
+    action->setText(i18n("Draw the 3D View in a &Native Window"));
+    action->setToolTip(i18n("Faster, but without ribbons, multiple views, playback and the other 3D view controls"));
+    action->setCheckable(true);
+    action->setChecked(m_lateral.get<Viewer3D>("3d")->backend() == Viewer3D::WindowBackend);
+    connect(action, &QAction::toggled, this, [this](bool checked) {
+        m_lateral.get<Viewer3D>("3d")->setBackend(checked ? Viewer3D::WindowBackend : Viewer3D::QuickBackend);
+    });
+
     action = actionCollection()->addAction(QStringLiteral("quit"));
     action->setIcon(QIcon::fromTheme("application-exit", QIcon(":/icon/exit")));
 
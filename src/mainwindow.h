@@ -22,6 +22,7 @@
 #include <KXmlGui/KXmlGuiWindow>
 #include <QMap>
 #include <QPair>
+#include <QPointer>
 #include <QPushButton>
 #include <QStackedWidget>
 #include <QUrl>
@@ -65,6 +66,8 @@ private:
     QList<QUrl> m_openFiles;
     QString m_theme;
     QTabWidget *m_instances;
+    // Instance whose print of the drawn file the 3D view shows
+    QPointer<QWidget> m_printShown;
     bool askToClose();
     void atCoreInstanceNameChange(const QString &name);
     QString getTheme();
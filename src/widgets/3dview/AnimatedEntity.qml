@@ -6,16 +6,70 @@ import Qt3D.Extras 2.0
 import Qt3D.Logic 2.0
 import GridMesh 1.0
 import LineMesh 1.0
+import PositionTrace 1.0
+import ToolpathMaterial 1.0
 
 Entity {
     id: sceneRoot
 
+    property alias printTime: lineMesh.printTime
+    property alias layerCount: lineMesh.layerCount
+    property alias firstLayer: lineMesh.firstLayer
+    property alias lastLayer: lineMesh.lastLayer
+    property alias showExtrusions: lineMesh.showExtrusions
+    property alias showTravels: lineMesh.showTravels
+    property alias showRibbons: lineMesh.showRibbons
+    property alias colorScheme: lineMaterial.colorScheme
+    // Estimated print time in s the toolpath is drawn up to, -1 draws all of it
+    property alias playbackTime: lineMesh.playbackTime
+    property bool playing: false
+    // Simulated seconds per second
+    property real playbackSpeed: 10
+    // Size in pixels of the view, to know how much of the toolpath a pixel covers
+    property real viewportWidth: 1000
+    property real viewportHeight: 1000
+    // Smoothed frames per second
+    property real frameRate: 60
+    // Coarser levels of detail are drawn while the camera moves, full detail once it stops
+    property bool cameraMoving: false
+    // Extra coarsening when the frame rate is too low, kept between two moves
+    property int frameRateLevel: 0
+    // The camera in the top left quarter, and top, front and isometric views of the same entities in the others
+    property bool multiView: false
+    // What the fixed views look at, the build plate until a file is loaded
+    readonly property bool hasBounds: lineMesh.boundsMaximum.minus(lineMesh.boundsMinimum).length() > 0
+    readonly property vector3d boundsCenter: hasBounds ? lineMesh.boundsMinimum.plus(lineMesh.boundsMaximum).times(0.5) : Qt.vector3d(10, 10, 0)
+    readonly property real boundsExtent: {
+        var size = lineMesh.boundsMaximum.minus(lineMesh.boundsMinimum)
+        return hasBounds ? 0.6 * Math.max(size.x, size.y, size.z) + 0.5 : 11
+    }
     signal fpsChanged(var fps)
 
     function runLineMesh(path) {
         lineMesh.readAndRun(path)
     }
 
+    // Size of a pixel at the view center, in scene units
+    function pixelSize() {
+        var distance = camera.position.minus(camera.viewCenter).length()
+        var height = multiView ? viewportHeight / 2 : viewportHeight
+        return 2 * distance * Math.tan(camera.fieldOfView * Math.PI / 360) / Math.max(height, 1)
+    }
+
+    function updateDetailLevel() {
+        if (!cameraMoving) {
+            lineMesh.detailLevel = 0
+            return
+        }
+        lineMesh.detailLevel = Math.max(lineMesh.detailLevelFor(pixelSize()), frameRateLevel)
+    }
+
+    function cameraMoved() {
+        cameraMoving = true
+        updateDetailLevel()
+        stillTimer.restart()
+    }
+
     Camera {
         id: camera
         projectionType: CameraLens.PerspectiveProjection
@@ -30,6 +84,78 @@ Entity {
 
     FirstPersonCameraController { camera: camera }
 
+    // Fixed orthographic views, the same aspect ratio as the main camera
+    Camera {
+        id: topCamera
+        projectionType: CameraLens.OrthographicProjection
+        left: -sceneRoot.boundsExtent * viewportWidth / Math.max(viewportHeight, 1)
+        right: -left
+        bottom: -sceneRoot.boundsExtent
+        top: sceneRoot.boundsExtent
+        nearPlane: 0.01
+        farPlane: 1000.0
+        position: sceneRoot.boundsCenter.plus(Qt.vector3d(0, 0, 100))
+        upVector: Qt.vector3d(0, 1, 0)
+        viewCenter: sceneRoot.boundsCenter
+    }
+
+    Camera {
+        id: frontCamera
+        projectionType: CameraLens.OrthographicProjection
+        left: topCamera.left
+        right: topCamera.right
+        bottom: topCamera.bottom
+        top: topCamera.top
+        nearPlane: 0.01
+        farPlane: 1000.0
+        position: sceneRoot.boundsCenter.plus(Qt.vector3d(0, -100, 0))
+        upVector: Qt.vector3d(0, 0, 1)
+        viewCenter: sceneRoot.boundsCenter
+    }
+
+    Camera {
+        id: isoCamera
+        projectionType: CameraLens.OrthographicProjection
+        left: topCamera.left
+        right: topCamera.right
+        bottom: topCamera.bottom
+        top: topCamera.top
+        nearPlane: 0.01
+        farPlane: 1000.0
+        position: sceneRoot.boundsCenter.plus(Qt.vector3d(100, -100, 100))
+        upVector: Qt.vector3d(0, 0, 1)
+        viewCenter: sceneRoot.boundsCenter
+    }
+
+    Connections {
+        target: camera
+        onPositionChanged: sceneRoot.cameraMoved()
+        onViewCenterChanged: sceneRoot.cameraMoved()
+    }
+
+    Timer {
+        id: stillTimer
+        interval: 300
+        onTriggered: {
+            sceneRoot.cameraMoving = false
+            sceneRoot.updateDetailLevel()
+        }
+    }
+
+    Timer {
+        interval: 250
+        repeat: true
+        running: sceneRoot.cameraMoving
+        onTriggered: {
+            if (sceneRoot.frameRate < 30) {
+                sceneRoot.frameRateLevel = Math.min(sceneRoot.frameRateLevel + 1, lineMesh.detailLevelCount - 1)
+            } else if (sceneRoot.frameRate > 50) {
+                sceneRoot.frameRateLevel = Math.max(sceneRoot.frameRateLevel - 1, 0)
+            }
+            sceneRoot.updateDetailLevel()
+        }
+    }
+
     components: [
         RenderSettings {
             activeFrameGraph: ClearBuffers {
@@ -45,22 +171,83 @@ Entity {
 
                     Viewport {
                         id: topLeftViewport
+                        normalizedRect: sceneRoot.multiView ? Qt.rect(0, 0, 0.5, 0.5) : Qt.rect(0, 0, 1, 1)
                         CameraSelector {
                             id: cameraSelectorTopLeftViewport
                             camera: camera
                         }
                     }
+
+                    // The other views draw the same entities, nothing more is uploaded.
+                    // Their NoDraw is enabled in single view, so they cost no draw call.
+                    Viewport {
+                        id: topRightViewport
+                        normalizedRect: Qt.rect(0.5, 0, 0.5, 0.5)
+                        CameraSelector {
+                            camera: topCamera
+                            NoDraw { enabled: !sceneRoot.multiView }
+                        }
+                    }
+
+                    Viewport {
+                        id: bottomLeftViewport
+                        normalizedRect: Qt.rect(0, 0.5, 0.5, 0.5)
+                        CameraSelector {
+                            camera: frontCamera
+                            NoDraw { enabled: !sceneRoot.multiView }
+                        }
+                    }
+
+                    Viewport {
+                        id: bottomRightViewport
+                        normalizedRect: Qt.rect(0.5, 0.5, 0.5, 0.5)
+                        CameraSelector {
+                            camera: isoCamera
+                            NoDraw { enabled: !sceneRoot.multiView }
+                        }
+                    }
                 }
             }
         },
-        InputSettings { }
+        InputSettings { },
+        mouseHandler
     ]
 
+    MouseDevice {
+        id: mouseDevice
+    }
+
+    MouseHandler {
+        id: mouseHandler
+        sourceDevice: mouseDevice
+        property point pressPosition
+        onPressed: pressPosition = Qt.point(mouse.x, mouse.y)
+        // Clicks only, not the end of a camera drag
+        onReleased: {
+            // Picking follows the main camera, in its quarter only in multiple views
+            var width = multiView ? viewportWidth / 2 : viewportWidth
+            var height = multiView ? viewportHeight / 2 : viewportHeight
+            if (mouse.x < width && mouse.y < height
+                    && Math.abs(mouse.x - pressPosition.x) + Math.abs(mouse.y - pressPosition.y) < 4) {
+                lineMesh.pick(Qt.point(2 * mouse.x / width - 1, 1 - 2 * mouse.y / height), 4 * pixelSize())
+            }
+        }
+    }
+
     FrameAction {
         id: frameAction
 
         onTriggered: {
+            sceneRoot.frameRate = 0.9 * sceneRoot.frameRate + 0.1 / Math.max(dt, 0.001)
             sceneRoot.fpsChanged(1/dt)
+            if (sceneRoot.playing) {
+                var time = Math.max(lineMesh.playbackTime, 0) + dt * sceneRoot.playbackSpeed
+                if (time >= lineMesh.printTime) {
+                    time = lineMesh.printTime
+                    sceneRoot.playing = false
+                }
+                lineMesh.playbackTime = time
+            }
         }
     }
 
@@ -73,6 +260,12 @@ Entity {
         id: lineMesh
         objectName: "lineMesh"
         enabled: true
+        material: lineMaterial
+        travelMaterial: travelMaterial
+        printedMaterial: printedMaterial
+        viewProjection: camera.projectionMatrix.times(camera.viewMatrix)
+        // The other views would miss what the main camera does not see
+        frustumCulling: !sceneRoot.multiView
     }
 
     PhongMaterial {
@@ -80,9 +273,23 @@ Entity {
         ambient: "darkBlue"
     }
 
-    PhongMaterial {
+    ToolpathMaterial {
         id: lineMaterial
-        ambient: "darkGreen"
+        maxFeedRate: lineMesh.maxFeedRate
+        layerCount: lineMesh.layerCount
+    }
+
+    ToolpathMaterial {
+        id: printedMaterial
+        colorScheme: lineMaterial.colorScheme
+        maxFeedRate: lineMesh.maxFeedRate
+        layerCount: lineMesh.layerCount
+        brightness: 0.35
+    }
+
+    PhongMaterial {
+        id: travelMaterial
+        ambient: "gray"
     }
 
     Entity {
@@ -90,8 +297,40 @@ Entity {
         components: [ gridMesh, material ]
     }
 
+    // Nozzle during playback
+    SphereMesh {
+        id: nozzleMesh
+        radius: 0.08
+    }
+
+    PhongMaterial {
+        id: nozzleMaterial
+        ambient: "red"
+    }
+
+    Transform {
+        id: nozzleTransform
+        translation: lineMesh.nozzlePosition
+    }
+
+    Entity {
+        id: nozzleEntity
+        enabled: lineMesh.playbackTime >= 0
+        components: [ nozzleMesh, nozzleMaterial, nozzleTransform ]
+    }
+
+    // Where the printer reported being, next to the planned toolpath
+    PositionTrace {
+        id: positionTrace
+        objectName: "positionTrace"
+    }
+
+    PerVertexColorMaterial {
+        id: traceMaterial
+    }
+
     Entity {
-        id: lineEntity
-        components: [ lineMesh, lineMaterial ]
+        id: traceEntity
+        components: [ positionTrace, traceMaterial ]
     }
 }
@@ -18,111 +18,646 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-#include <QList>
+#include <cstring>
+#include <functional>
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QHash>
 #include <QString>
-#include <QTextStream>
+#include <QThread>
+#include <QtConcurrentMap>
 #include <QVariant>
+#include <QVector>
+#include <QVector3D>
 #include <QVector4D>
 #include "fileloader.h"
+#include "gcodemetadata.h"
+#include "gcodeparser.h"
+#include "geometrycache.h"
+#include "printtimeestimator.h"
+#include "vertexbatch.h"
 
 namespace
 {
-const static QString _commentChar = QStringLiteral(";");
-const static QStringList _moveCommands = {QStringLiteral("G0"), QStringLiteral("G1")};
-const static QString _space = QStringLiteral(" ");
-const static QString _E = QStringLiteral("E");
-const static QString _X = QStringLiteral("X");
-const static QString _Y = QStringLiteral("Y");
-const static QString _Z = QStringLiteral("Z");
+const int _chunkCount = 128;
+const qint64 _minChunkSize = 256 * 1024;
+const qint64 _maxChunkSize = 32 * 1024 * 1024;
+const qint64 _firstChunkSize = 64 * 1024;
+const qint64 _maxBatchSize = 256 * 1024 * 1024;
+// Cached batches are unpacked in slices, to notice cancellation and never hold the whole file unpacked
+const int _estimateSliceSize = 1024 * 1024;
+
+// Vertex buffers stay far from the 2 GB QByteArray limit
+const qint64 _maxBatchVertices = 64 * 1024 * 1024;
+const float _maxQuantized = 65535;
+// Quantization steps stay below 0.02 mm, batches spread over more are sent as floats
+const float _maxQuantizedExtent = _maxQuantized * 0.002f;
+// Build volumes are in mm, vertices in cm
+const float _vertexUnitsPerMm = 0.1f;
+// Lines of the previous level merged at most into one, bounds the distance checks
+const int _maxMergedLines = 16;
+
+// Squared distance between point and the segment from start to end
+inline float distanceToSegmentSquared(const QVector3D &point, const QVector3D &start, const QVector3D &end)
+{
+    const QVector3D segment = end - start;
+    const float lengthSquared = segment.lengthSquared();
+    const float t = lengthSquared > 0 ? qBound(0.0f, QVector3D::dotProduct(point - start, segment) / lengthSquared, 1.0f) : 0;
+    return (point - start - segment * t).lengthSquared();
 }
 
-FileLoader::FileLoader(QString &fileName, QObject *parent) :
-    QObject(parent)
-    , _file(fileName)
+inline QVector3D lowest(const QVector3D &a, const QVector3D &b)
 {
+    return QVector3D(qMin(a.x(), b.x()), qMin(a.y(), b.y()), qMin(a.z(), b.z()));
 }
 
-FileLoader::~FileLoader()
+inline QVector3D highest(const QVector3D &a, const QVector3D &b)
 {
+    return QVector3D(qMax(a.x(), b.x()), qMax(a.y(), b.y()), qMax(a.z(), b.z()));
 }
 
-void FileLoader::run()
+// Box of count vertices, count must not be 0
+void bounds(const QVector4D *vertices, qint64 count, QVector3D &minimum, QVector3D &maximum)
 {
-    QList<QVector4D> pos;
-    qint64 totalSize = _file.bytesAvailable();
-    qint64 stillSize = totalSize;
-
-    if (_file.open(QIODevice::ReadOnly)) {
-        float lastPerc = 0.0;
-        QTextStream in(&_file);
-        while (!in.atEnd()) {
-            //Get each line
-            QString line = in.readLine();
-            stillSize -= line.size() + 1; // +1 endl
-            const float perc = (totalSize -  stillSize) * 100.0 / totalSize;
-            if (perc - lastPerc > 1) {
-                emit percentUpdate((int)perc);
-                lastPerc = perc;
-            }
-            line = line.simplified();
-            //Is it a comment ? Drop it
-            if (line.isEmpty()) {
-                continue;
+    minimum = maximum = vertices[0].toVector3D();
+    for (qint64 i = 1; i < count; ++i) {
+        const QVector3D position = vertices[i].toVector3D();
+        minimum = lowest(minimum, position);
+        maximum = highest(maximum, position);
+    }
+}
+
+// Sends the vertices of batches back to receive in slices of at most _estimateSliceSize, in file order and without
+// the vertex every batch repeats from the previous one, until receive returns false.
+// Positions come back within a quantization step, the filament from the extrusion per length of the move,
+// so moves of the filament alone come back without it.
+void unpack(const QVector<VertexBatch> &batches, const std::function<bool(const QVector4D *, const float *, int)> &receive)
+{
+    QVector<QVector4D> vertices;
+    QVector<float> feedRates;
+    vertices.reserve(_estimateSliceSize);
+    feedRates.reserve(_estimateSliceSize);
+    QVector3D previous;
+    bool hasPrevious = false;
+    for (const VertexBatch &batch : batches) {
+        const int stride = batch.isQuantized() ? sizeof(VertexBatch::QuantizedVertex) : sizeof(VertexBatch::Vertex);
+        const int count = batch.vertices.size() / stride;
+        const QVector3D step = batch.quantizationStep();
+        for (int i = hasPrevious ? 1 : 0; i < count; ++i) {
+            const char *vertex = batch.vertices.constData() + qint64(i) * stride;
+            QVector3D position;
+            VertexBatch::Attributes attributes;
+            if (batch.isQuantized()) {
+                const auto *quantized = reinterpret_cast<const VertexBatch::QuantizedVertex *>(vertex);
+                position = batch.quantizationOrigin + QVector3D(quantized->x, quantized->y, quantized->z) * step;
+                attributes = quantized->attributes;
+            } else {
+                const auto *packed = reinterpret_cast<const VertexBatch::Vertex *>(vertex);
+                position = QVector3D(packed->x, packed->y, packed->z);
+                attributes = packed->attributes;
             }
-            //Remove comment in the end of command
-            if (line.indexOf(_commentChar) != -1) {
-                line.resize(line.indexOf(_commentChar));
-                //Remove trailing spaces
-                line = line.simplified();
+            const float filament = hasPrevious ? attributes.extrusion / 65536.0f * (position - previous).length() : 0;
+            vertices.append(QVector4D(position, filament));
+            feedRates.append(attributes.feedRate / 10.0f);
+            previous = position;
+            hasPrevious = true;
+            if (vertices.size() == _estimateSliceSize) {
+                if (!receive(vertices.constData(), feedRates.constData(), vertices.size())) {
+                    return;
+                }
+                vertices.resize(0);
+                feedRates.resize(0);
             }
+        }
+    }
+    if (!vertices.isEmpty()) {
+        receive(vertices.constData(), feedRates.constData(), vertices.size());
+    }
+}
 
-            //Split command and args
-            QStringList commAndArgs = line.split(_space);
+// Packs vertices and their attributes in batches of at most _maxBatchVertices, with a line per move.
+// Every batch but the first starts with the last vertex of the previous one, so no move is lost between them.
+// Layers and features come from metadata, it must already hold the chunks given to add().
+// Every batch is quantized across its own box, the build volume joined with the bounds of its vertices,
+// so no vertex is ever moved. It holds floats when the box is too large for the 16-bit steps.
+// The coarser levels of detail and the index are built when a batch is flushed, on the loader thread.
+class VertexPacker
+{
+public:
+    typedef VertexBatch::Vertex Vertex;
+    typedef VertexBatch::QuantizedVertex QuantizedVertex;
 
-            if (_moveCommands.contains(commAndArgs[0])) {
-                QVector4D actualPos;
-                //Compute args
-                commAndArgs.removeFirst();
-                for (QString element : commAndArgs) {
-                    if (element.contains(_X)) {
-                        actualPos.setX(element.remove(0, 1).toFloat() / 10);
-                    }
+    // Positions are quantized when quantize is set, buildVolume is in vertex units and null when unknown
+    VertexPacker(const GCodeMetadata &metadata, bool quantize, const QVector3D &buildVolume,
+                 const std::function<void(const VertexBatch &)> &send) :
+        _metadata(metadata)
+        , _send(send)
+        , _quantize(quantize)
+        , _buildVolume(buildVolume)
+    {
+    }
 
-                    if (element.contains(_Y)) {
-                        actualPos.setY(element.remove(0, 1).toFloat() / 10);
-                    }
+    // count vertices within [minimum, maximum] are added before the next flush(), one allocation and one box per batch.
+    // Only called between batches.
+    void reserve(qint64 count, const QVector3D &minimum, const QVector3D &maximum)
+    {
+        _remaining = count;
+        setBox(minimum, maximum);
+    }
 
-                    if (element.contains(_Z)) {
-                        actualPos.setZ(element.remove(0, 1).toFloat() / 10);
-                    }
+    void add(const QVector4D *vertices, const float *feedRates, qint64 count)
+    {
+        const QVector<GCodeLayer> &layers = _metadata.layers;
+        const QVector<GCodeFeature> &features = _metadata.features;
+        while (count > 0) {
+            if (_out == _end) {
+                flush();
+                start();
+            }
+            const qint64 size = qMin(count, qint64(_end - _out) / _stride);
+            for (qint64 i = 0; i < size; ++i, ++_vertex) {
+                while (_layer + 1 < layers.size() && layers.at(_layer + 1).vertexOffset <= _vertex) {
+                    ++_layer;
+                }
+                while (_feature + 1 < features.size() && features.at(_feature + 1).vertex <= _vertex) {
+                    ++_feature;
+                }
+
+                const QVector4D &vertex = vertices[i];
+                VertexBatch::Attributes attributes;
+                attributes.feedRate = quint16(qBound(0.0f, feedRates[i] * 10, 65535.0f));
+                attributes.extrusion = 0;
+                attributes.layer = quint16(qBound(0, _layer, 65535));
+                attributes.feature = _feature >= 0 ? features.at(_feature).feature : GCodeParser::UnknownFeature;
+                attributes.unused = 0;
 
-                    if (element.contains(_E)) {
-                        actualPos.setW(element.remove(0, 1).toFloat() / 10);
+                // The move from the previous vertex, if the head moves at all
+                if (_out != _begin) {
+                    const QVector3D delta = vertex.toVector3D() - _previous.toVector3D();
+                    if (!delta.isNull()) {
+                        const quint32 index = quint32((_out - _begin) / _stride);
+                        if (vertex.w() > 0) {
+                            attributes.extrusion = quint16(qMin(vertex.w() / delta.length() * 65536, 65535.0f));
+                            *_extrusions++ = index - 1;
+                            *_extrusions++ = index;
+                        } else {
+                            _travels.append(index - 1);
+                            _travels.append(index);
+                        }
                     }
                 }
 
-                if (!pos.isEmpty()) {
-                    if (!line.contains(_X)) {
-                        actualPos.setX(pos.last().x());
-                    }
+                pack(vertex, attributes);
+                _previous = vertex;
+                _previousAttributes = attributes;
+                _hasPrevious = true;
+            }
+            vertices += size;
+            feedRates += size;
+            count -= size;
+            _remaining -= size;
+        }
+    }
 
-                    if (!line.contains(_Y)) {
-                        actualPos.setY(pos.last().y());
-                    }
+    void flush()
+    {
+        if (_batch.vertices.isEmpty()) {
+            return;
+        }
+        // Shortened if fewer vertices than reserved came, the travels go after the extrusions
+        _batch.vertices.resize(int(_out - _batch.vertices.data()));
+        VertexBatch::Level &full = _batch.levels[0];
+        full.extrusionIndexCount = int(_extrusions - reinterpret_cast<quint32 *>(_batch.lines.data()));
+        full.indexCount = full.extrusionIndexCount + _travels.size();
+        memcpy(_extrusions, _travels.constData(), _travels.size() * sizeof(quint32));
+        _batch.lines.resize(int(full.indexCount * sizeof(quint32)));
 
-                    if (!line.contains(_Z)) {
-                        actualPos.setZ(pos.last().z());
-                    }
+        // Every coarser level merges the lines of the previous one, they go after the full detail
+        QByteArray coarse;
+        QVector<quint32> previous;
+        QVector<quint32> merged;
+        const quint32 *source = reinterpret_cast<const quint32 *>(_batch.lines.constData());
+        for (int level = 1; level < VertexBatch::levelCount; ++level) {
+            const VertexBatch::Level &sourceLevel = _batch.levels[level - 1];
+            VertexBatch::Level &current = _batch.levels[level];
+            const float tolerance = VertexBatch::levelTolerance(level);
+            merged.resize(0);
+            merge(source, sourceLevel.extrusionIndexCount, tolerance, merged);
+            current.extrusionIndexCount = merged.size();
+            merge(source + sourceLevel.extrusionIndexCount, sourceLevel.indexCount - sourceLevel.extrusionIndexCount, tolerance, merged);
+            current.firstIndex = full.indexCount + int(coarse.size() / sizeof(quint32));
+            current.indexCount = merged.size();
+            coarse.append(reinterpret_cast<const char *>(merged.constData()), int(merged.size() * sizeof(quint32)));
+            previous.swap(merged);
+            source = previous.constData();
+        }
+        _batch.lines.append(coarse);
+        _batch.lines.squeeze();
 
-                    if (!line.contains(_E)) {
-                        actualPos.setW(pos.last().w());
-                    }
+        _batch.quantizationOrigin = _origin;
+        _batch.quantizationSize = _size;
+        _batch.index.build(_batch);
+        _send(_batch);
+        _batch = VertexBatch();
+        _travels.resize(0);
+        _begin = _out = _end = nullptr;
+    }
+
+private:
+    void start()
+    {
+        const qint64 size = qMin(qMax<qint64>(_remaining, 1), _maxBatchVertices) + (_hasPrevious ? 1 : 0);
+        _batch.vertices.resize(int(size * _stride));
+        // At most one line per vertex
+        _batch.lines.resize(int(size * 2 * sizeof(quint32)));
+        _begin = _out = _batch.vertices.data();
+        _end = _out + size * _stride;
+        _extrusions = reinterpret_cast<quint32 *>(_batch.lines.data());
+        // Packed again, the box of the previous batch may be another one
+        if (_hasPrevious) {
+            pack(_previous, _previousAttributes);
+        }
+    }
+
+    // The box of the next batch, the previous vertex it repeats is in it too
+    void setBox(QVector3D minimum, QVector3D maximum)
+    {
+        _origin = _size = _scale = QVector3D();
+        _stride = sizeof(Vertex);
+        if (!_quantize) {
+            return;
+        }
+        if (_hasPrevious) {
+            minimum = lowest(minimum, _previous.toVector3D());
+            maximum = highest(maximum, _previous.toVector3D());
+        }
+        if (!_buildVolume.isNull()) {
+            minimum = lowest(minimum, QVector3D());
+            maximum = highest(maximum, _buildVolume);
+        }
+        const QVector3D size = maximum - minimum;
+        if (qMax(size.x(), qMax(size.y(), size.z())) > _maxQuantizedExtent) {
+            return;
+        }
+        // Flat files still need a height to divide by
+        _origin = minimum;
+        _size = QVector3D(qMax(size.x(), _vertexUnitsPerMm), qMax(size.y(), _vertexUnitsPerMm), qMax(size.z(), _vertexUnitsPerMm));
+        _scale = QVector3D(_maxQuantized, _maxQuantized, _maxQuantized) / _size;
+        _stride = sizeof(QuantizedVertex);
+    }
+
+    // Writes the vertex at the end of the batch, within the box when it is quantized
+    void pack(const QVector4D &vertex, const VertexBatch::Attributes &attributes)
+    {
+        if (_size.isNull()) {
+            Vertex &packed = *reinterpret_cast<Vertex *>(_out);
+            packed.x = vertex.x();
+            packed.y = vertex.y();
+            packed.z = vertex.z();
+            packed.attributes = attributes;
+        } else {
+            const QVector3D position = (vertex.toVector3D() - _origin) * _scale;
+            QuantizedVertex &packed = *reinterpret_cast<QuantizedVertex *>(_out);
+            packed.x = quint16(position.x() + 0.5f);
+            packed.y = quint16(position.y() + 0.5f);
+            packed.z = quint16(position.z() + 0.5f);
+            packed.unused = 0;
+            packed.attributes = attributes;
+        }
+        _out += _stride;
+    }
+
+    // Appends the lines of indexCount indices, where lines that continue each other are merged into one
+    // as long as the vertices they skip stay within tolerance, and the layer and the feature do not change
+    void merge(const quint32 *lines, int indexCount, float tolerance, QVector<quint32> &out) const
+    {
+        const int lineCount = indexCount / 2;
+        const float toleranceSquared = tolerance * tolerance;
+        for (int first = 0; first < lineCount;) {
+            const QVector3D start = position(lines[first * 2]);
+            const VertexBatch::Attributes &attributes = this->attributes(lines[first * 2 + 1]);
+            int last = first;
+            while (last + 1 < lineCount && last + 1 - first < _maxMergedLines && lines[(last + 1) * 2] == lines[last * 2 + 1]) {
+                const quint32 end = lines[(last + 1) * 2 + 1];
+                const VertexBatch::Attributes &endAttributes = this->attributes(end);
+                if (endAttributes.layer != attributes.layer || endAttributes.feature != attributes.feature) {
+                    break;
+                }
+                const QVector3D endPosition = position(end);
+                bool within = true;
+                for (int i = first; i <= last && within; ++i) {
+                    within = distanceToSegmentSquared(position(lines[i * 2 + 1]), start, endPosition) <= toleranceSquared;
                 }
+                if (!within) {
+                    break;
+                }
+                ++last;
+            }
+            out.append(lines[first * 2]);
+            out.append(lines[last * 2 + 1]);
+            first = last + 1;
+        }
+    }
+
+    // Position of a vertex of the batch in vertex units, quantized ones are relative to the origin
+    QVector3D position(quint32 index) const
+    {
+        const char *vertex = _batch.vertices.constData() + qint64(index) * _stride;
+        if (_size.isNull()) {
+            const Vertex &packed = *reinterpret_cast<const Vertex *>(vertex);
+            return QVector3D(packed.x, packed.y, packed.z);
+        }
+        const QuantizedVertex &packed = *reinterpret_cast<const QuantizedVertex *>(vertex);
+        return QVector3D(packed.x, packed.y, packed.z) / _scale;
+    }
+
+    const VertexBatch::Attributes &attributes(quint32 index) const
+    {
+        const char *vertex = _batch.vertices.constData() + qint64(index) * _stride;
+        if (_size.isNull()) {
+            return reinterpret_cast<const Vertex *>(vertex)->attributes;
+        }
+        return reinterpret_cast<const QuantizedVertex *>(vertex)->attributes;
+    }
+
+    const GCodeMetadata &_metadata;
+    std::function<void(const VertexBatch &)> _send;
+    const bool _quantize;
+    const QVector3D _buildVolume;
+    // Box of the current batch, null size when it holds floats
+    QVector3D _origin;
+    QVector3D _size;
+    QVector3D _scale;
+    int _stride = sizeof(Vertex);
+    VertexBatch _batch;
+    char *_begin = nullptr;
+    char *_out = nullptr;
+    char *_end = nullptr;
+    quint32 *_extrusions = nullptr;
+    QVector<quint32> _travels;
+    qint64 _remaining = 0;
+    // Index in the whole file of the next vertex, its layer and feature
+    qint64 _vertex = 0;
+    int _layer = 0;
+    int _feature = -1;
+    // Last vertex added, the first one of the next batch
+    QVector4D _previous;
+    VertexBatch::Attributes _previousAttributes;
+    bool _hasPrevious = false;
+};
+}
+
+FileLoader::FileLoader(QString &fileName, QObject *parent) :
+    QObject(parent)
+    , _file(fileName)
+    , _quantize(false)
+    , _canceled(0)
+{
+    _options.canceled = &_canceled;
+}
+
+FileLoader::~FileLoader()
+{
+}
+
+void FileLoader::setOptions(const GCodeParser::Options &options)
+{
+    _options = options;
+    _options.canceled = &_canceled;
+}
+
+void FileLoader::setMotionLimits(const MotionLimits &limits)
+{
+    _limits = limits;
+}
+
+void FileLoader::setQuantization(bool quantize, const QVector3D &buildVolume)
+{
+    _quantize = quantize;
+    _buildVolume = buildVolume;
+}
+
+void FileLoader::cancel()
+{
+    _canceled.store(1);
+}
 
-                pos.append(actualPos);
+void FileLoader::run()
+{
+    if (!_canceled.load() && _file.open(QIODevice::ReadOnly)) {
+        const qint64 totalSize = _file.size();
+        //Parse straight from the page cache, fallback to a single read if mapping is not possible
+        QByteArray buffer;
+        const char *data = nullptr;
+        if (totalSize > 0) {
+            data = reinterpret_cast<const char *>(_file.map(0, totalSize));
+            if (!data) {
+                buffer = _file.readAll();
+                data = buffer.constData();
             }
         }
+
+        GeometryCache cache(_file.fileName(), data, totalSize, _options);
+        if (!cache.open() || !loadCached(cache)) {
+            cache.close();
+            parseFile(cache, data, totalSize);
+        }
+        //Also drops the mapping
+        _file.close();
     }
-    emit percentUpdate(100);
-    emit posFinished(pos);
+    // Last, the loader may be deleted as soon as finished() is emitted
+    finish();
 };
+
+void FileLoader::parseFile(GeometryCache &cache, const char *data, qint64 totalSize)
+{
+    const bool caching = cache.beginWrite();
+
+    const char *begin = data;
+    const char *end = data + totalSize;
+    // Enough chunks to keep every core busy and to report progress, big enough to amortize the scheduling.
+    // The first chunk is small so the first layers can be shown right away.
+    const qint64 chunkSize = qBound<qint64>(_minChunkSize, totalSize / _chunkCount, _maxChunkSize);
+    QVector<GCodeParser::Chunk> chunks = GCodeParser::split(begin, end, chunkSize, _firstChunkSize);
+
+    QAtomicInteger<qint64> parsedSize(0);
+    auto parse = [this, &parsedSize, totalSize](GCodeParser::Chunk & chunk) {
+        GCodeParser::parse(chunk, _options);
+        const qint64 size = chunk.end - chunk.begin;
+        emit percentUpdate(int((parsedSize.fetchAndAddRelaxed(size) + size) * 100 / totalSize));
+    };
+    // Box of the vertices of every chunk, for the quantization
+    QVector<QVector3D> minimums(chunks.size());
+    QVector<QVector3D> maximums(chunks.size());
+    auto resolve = [this, &chunks, &minimums, &maximums](GCodeParser::Chunk & chunk) {
+        GCodeParser::resolve(chunk, _options);
+        const int i = int(&chunk - chunks.constData());
+        if (!chunk.vertices.isEmpty()) {
+            bounds(chunk.vertices.constData(), chunk.vertices.size(), minimums[i], maximums[i]);
+        }
+    };
+
+    GCodeMetadata metadata;
+    PrintTimeEstimator estimator(_limits);
+    VertexPacker packer(metadata, _quantize, buildVolume(), [this, &cache, caching](const VertexBatch & batch) {
+        emit posBatch(batch);
+        if (caching) {
+            cache.write(batch);
+        }
+    });
+    // Chunks are handled in batches that double in size, every batch is sent as soon as it is resolved
+    qint64 batchSize = chunkSize * QThread::idealThreadCount();
+    int batchBegin = 0;
+    while (batchBegin < chunks.size() && !_canceled.load()) {
+        int batchEnd = batchBegin + 1;
+        if (batchBegin == 0) {
+            // The start code sets the modes most files keep until the end, assume them for the other chunks
+            chunks[0].entryKnown = true;
+            parse(chunks[0]);
+            for (int i = 1; i < chunks.size(); ++i) {
+                chunks[i].entryModal = chunks.at(0).exitModal;
+            }
+        } else {
+            const char *batchStart = chunks.at(batchBegin).begin;
+            while (batchEnd < chunks.size() && chunks.at(batchEnd).end - batchStart <= batchSize) {
+                ++batchEnd;
+            }
+            QtConcurrent::blockingMap(chunks.begin() + batchBegin, chunks.begin() + batchEnd, parse);
+            batchSize = qMin(batchSize * 2, _maxBatchSize);
+        }
+
+        if (_canceled.load()) {
+            break;
+        }
+        for (int i = batchBegin; i < batchEnd; ++i) {
+            GCodeParser::stitch(chunks[i], i > 0 ? &chunks.at(i - 1) : nullptr, _options);
+        }
+        QtConcurrent::blockingMap(chunks.begin() + batchBegin, chunks.begin() + batchEnd, resolve);
+        if (_canceled.load()) {
+            break;
+        }
+
+        qint64 vertexCount = 0;
+        QVector3D minimum;
+        QVector3D maximum;
+        for (int i = batchBegin; i < batchEnd; ++i) {
+            if (chunks.at(i).vertices.isEmpty()) {
+                continue;
+            }
+            minimum = vertexCount > 0 ? lowest(minimum, minimums.at(i)) : minimums.at(i);
+            maximum = vertexCount > 0 ? highest(maximum, maximums.at(i)) : maximums.at(i);
+            vertexCount += chunks.at(i).vertices.size();
+        }
+        // Packed straight for the vertex buffer
+        packer.reserve(vertexCount, minimum, maximum);
+        for (int i = batchBegin; i < batchEnd; ++i) {
+            metadata.add(chunks.at(i), chunks.at(i).begin - begin);
+            const auto &vertices = chunks.at(i).vertices;
+            const auto &feedRates = chunks.at(i).feedRates;
+            estimator.add(vertices.constData(), feedRates.constData(), vertices.size(), metadata);
+            packer.add(vertices.constData(), feedRates.constData(), vertices.size());
+            chunks[i].vertices = QVector<QVector4D>();
+            chunks[i].feedRates = QVector<float>();
+        }
+        packer.flush();
+        batchBegin = batchEnd;
+    }
+
+    metadata.finish();
+    estimator.finish(metadata);
+    metadata.setPrintTime(estimator.time());
+    if (!_canceled.load()) {
+        emit metadataFinished(metadata);
+        if (caching) {
+            cache.commit(metadata, qHash(_limits), packingHash());
+        }
+    }
+}
+
+bool FileLoader::loadCached(const GeometryCache &cache)
+{
+    const QVector<VertexBatch> batches = cache.batches();
+    if (batches.isEmpty() && cache.vertexCount() > 0) {
+        return false;
+    }
+    GCodeMetadata metadata = cache.metadata();
+    // The batches as they were sent, levels and index included, unless they were packed otherwise
+    if (cache.packingHash() == packingHash()) {
+        for (const VertexBatch &batch : batches) {
+            if (_canceled.load()) {
+                break;
+            }
+            emit posBatch(batch);
+        }
+    } else if (cache.vertexCount() > 0) {
+        // Unpacked twice, once for the box and once for the packer
+        QVector3D minimum;
+        QVector3D maximum;
+        bool hasBounds = false;
+        unpack(batches, [this, &minimum, &maximum, &hasBounds](const QVector4D * vertices, const float *, int count) {
+            QVector3D sliceMinimum;
+            QVector3D sliceMaximum;
+            bounds(vertices, count, sliceMinimum, sliceMaximum);
+            minimum = hasBounds ? lowest(minimum, sliceMinimum) : sliceMinimum;
+            maximum = hasBounds ? highest(maximum, sliceMaximum) : sliceMaximum;
+            hasBounds = true;
+            return !_canceled.load();
+        });
+        VertexPacker packer(metadata, _quantize, buildVolume(), [this](const VertexBatch & batch) {
+            if (!_canceled.load()) {
+                emit posBatch(batch);
+            }
+        });
+        packer.reserve(cache.vertexCount(), minimum, maximum);
+        unpack(batches, [this, &packer](const QVector4D * vertices, const float *feedRates, int count) {
+            if (_canceled.load()) {
+                return false;
+            }
+            packer.add(vertices, feedRates, count);
+            return true;
+        });
+        packer.flush();
+    }
+    if (_canceled.load()) {
+        return true;
+    }
+
+    // The entry was estimated with other limits, the times are computed again from the unpacked moves
+    if (cache.limitsHash() != qHash(_limits)) {
+        PrintTimeEstimator estimator(_limits);
+        metadata.times.clear();
+        unpack(batches, [this, &estimator, &metadata](const QVector4D * vertices, const float *feedRates, int count) {
+            estimator.add(vertices, feedRates, count, metadata);
+            return !_canceled.load();
+        });
+        estimator.finish(metadata);
+        metadata.setPrintTime(estimator.time());
+    }
+    if (!_canceled.load()) {
+        emit metadataFinished(metadata);
+    }
+    return true;
+}
+
+uint FileLoader::packingHash() const
+{
+    const QVector3D volume = buildVolume();
+    return qHash(volume.z(), qHash(volume.y(), qHash(volume.x(), qHash(_quantize))));
+}
+
+QVector3D FileLoader::buildVolume() const
+{
+    if (_buildVolume.x() > 0 && _buildVolume.y() > 0 && _buildVolume.z() > 0) {
+        return _buildVolume * _vertexUnitsPerMm;
+    }
+    return QVector3D();
+}
+
+void FileLoader::finish()
+{
+    if (!_canceled.load()) {
+        emit percentUpdate(100);
+        emit posFinished();
+    }
+    emit finished();
+}
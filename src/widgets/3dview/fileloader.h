@@ -20,29 +20,62 @@
 */
 #pragma once
 
+#include <QAtomicInt>
 #include <QFile>
-#include <QList>
 #include <QObject>
+#include <QRunnable>
 #include <QVariant>
+#include <QVector3D>
+#include "gcodemetadata.h"
+#include "gcodeparser.h"
+#include "printtimeestimator.h"
+#include "vertexbatch.h"
 
+class GeometryCache;
 class QString;
-class QVector4D;
 
-class FileLoader : public QObject
+class FileLoader : public QObject, public QRunnable
 {
     Q_OBJECT
 
 public:
     FileLoader(QString &fileName, QObject *parent = nullptr);
     ~FileLoader();
+    void setOptions(const GCodeParser::Options &options);
+    void setMotionLimits(const MotionLimits &limits);
+    // Positions are sent as 16-bit integers across the build volume, in mm, joined with the box of the vertices
+    // of every batch. Floats are sent otherwise, and for batches too large for the precision.
+    void setQuantization(bool quantize, const QVector3D &buildVolume);
+    // Thread safe, the load stops within milliseconds and nothing else is emitted but finished()
+    void cancel();
 
 private:
+    // False when the entry cannot be used, before anything is emitted
+    bool loadCached(const GeometryCache &cache);
+    void parseFile(GeometryCache &cache, const char *data, qint64 totalSize);
+    void finish();
+    // In vertex units, null when unknown
+    QVector3D buildVolume() const;
+    // Of the settings the batches are packed with, cached batches packed otherwise are packed again
+    uint packingHash() const;
+
     QFile _file;
+    GCodeParser::Options _options;
+    MotionLimits _limits;
+    bool _quantize;
+    QVector3D _buildVolume;
+    QAtomicInt _canceled;
 
 signals:
     void percentUpdate(QVariant var);
-    void posFinished(const QList<QVector4D> &pos);
+    // Geometry of the next part of the file, in file order
+    void posBatch(const VertexBatch &batch);
+    // Statistics and layer table, sent right before posFinished()
+    void metadataFinished(const GCodeMetadata &metadata);
+    void posFinished();
+    // Always emitted last, canceled or not
+    void finished();
 
 public slots:
-    void run();
+    void run() override;
 };
@@ -0,0 +1,336 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <QDataStream>
+#include <QIODevice>
+#include "gcodemetadata.h"
+#include "gcodetokenizer.h"
+
+namespace
+{
+// Vertices are in cm
+const float _mmPerUnit = 10;
+const quint32 _streamVersion = 6;
+// Bytes of a record in the stream, QDataStream writes floats as doubles
+const qint64 _layerSize = 6 * 8;
+const qint64 _positionSize = 4 * 8;
+const qint64 _featureSize = 8 + 1;
+const qint64 _arcSize = 8 + 4;
+const qint64 _timeSize = 8;
+// A new layer is at least this part of the first layer height away from the previous one.
+// Spiral vase files rise a little with every move, they would have a layer per move otherwise.
+const float _minimumLayerStep = 0.5f;
+// mm, for files whose first layer is at Z0
+const float _minimumLayerHeight = 0.01f;
+
+// Bytes left to read, counts read from a corrupt entry must not allocate more than that
+qint64 remaining(const QDataStream &stream, const QByteArray &data)
+{
+    return data.size() - stream.device()->pos();
+}
+}
+
+void GCodeMetadata::add(const GCodeParser::Chunk &chunk, qint64 chunkOffset)
+{
+    const QVector4D *vertices = chunk.vertices.constData();
+    const int count = chunk.vertices.size();
+    for (int m = 0; m < chunk.marks.size(); ++m) {
+        const GCodeParser::Mark &mark = chunk.marks.at(m);
+        const int end = m + 1 < chunk.marks.size() ? chunk.marks.at(m + 1).vertex : count;
+        if (mark.movesZ) {
+            _heightOffset = chunkOffset + mark.offset;
+            _heightVertex = vertexCount + mark.vertex;
+        }
+
+        // Everything up to the next mark is done at the height of the mark
+        double markFilament = 0;
+        bool extrudes = false;
+        for (int i = mark.vertex; i < end; ++i) {
+            const QVector4D &vertex = vertices[i];
+            const double extruded = double(vertex.w()) * _mmPerUnit;
+            markFilament += extruded;
+            if (extruded > 0) {
+                ++extrusionCount;
+                maxFeedRate = qMax(maxFeedRate, chunk.feedRates.at(i));
+                extrudes = true;
+                if (vertexCount + i > 0) {
+                    growBox(_previous);
+                }
+                growBox(vertex);
+            } else {
+                ++travelCount;
+            }
+            _previous = vertex;
+        }
+
+        const float z = vertices[mark.vertex].z() * _mmPerUnit;
+        if (extrudes && (layers.isEmpty() || qAbs(z - layers.last().z) >= qMax(layers.first().z * _minimumLayerStep, _minimumLayerHeight))) {
+            closeLayer(_heightVertex);
+            GCodeLayer layer;
+            layer.z = z;
+            layer.byteOffset = _heightOffset;
+            layer.vertexOffset = _heightVertex;
+            layers.append(layer);
+        }
+        if (!layers.isEmpty()) {
+            layers.last().filament += markFilament;
+        }
+        filament += markFilament;
+    }
+
+    for (const GCodeParser::FeatureMark &mark : chunk.features) {
+        if (!features.isEmpty() && features.last().feature == mark.feature) {
+            continue;
+        }
+        GCodeFeature feature;
+        feature.vertex = vertexCount + mark.vertex;
+        feature.feature = mark.feature;
+        features.append(feature);
+    }
+
+    for (const GCodeParser::Mark &mark : chunk.positions) {
+        GCodePosition position;
+        position.byteOffset = chunkOffset + mark.offset;
+        position.line = lineCount + mark.line;
+        position.vertex = vertexCount + mark.vertex;
+        positions.append(position);
+    }
+
+    for (const GCodeParser::ArcMark &mark : chunk.arcs) {
+        GCodeArc arc;
+        arc.vertex = vertexCount + mark.vertex;
+        arc.vertexCount = mark.vertexCount;
+        arcs.append(arc);
+    }
+
+    moveCount += chunk.moveCount;
+    arcCount += chunk.arcCount;
+    vertexCount += count;
+    byteCount += chunk.end - chunk.begin;
+    lineCount += chunk.lineCount;
+}
+
+void GCodeMetadata::finish()
+{
+    closeLayer(vertexCount);
+}
+
+void GCodeMetadata::setPrintTime(double time)
+{
+    printTime = time;
+    for (GCodeLayer &layer : layers) {
+        layer.time = timeAt(layer.byteOffset);
+    }
+}
+
+double GCodeMetadata::timeAt(qint64 byteOffset) const
+{
+    auto next = std::upper_bound(positions.constBegin(), positions.constEnd(), byteOffset,
+    [](qint64 offset, const GCodePosition & position) {
+        return offset < position.byteOffset;
+    });
+    if (next == positions.constBegin()) {
+        return 0;
+    }
+    // Linear between two known positions
+    const GCodePosition &previous = *(next - 1);
+    const qint64 endOffset = next == positions.constEnd() ? byteCount : next->byteOffset;
+    const double endTime = next == positions.constEnd() ? printTime : next->time;
+    if (endOffset <= previous.byteOffset) {
+        return previous.time;
+    }
+    const double ratio = double(qMin(byteOffset, endOffset) - previous.byteOffset) / (endOffset - previous.byteOffset);
+    return previous.time + (endTime - previous.time) * ratio;
+}
+
+qint64 GCodeMetadata::vertexAt(qint64 byteOffset) const
+{
+    auto next = std::upper_bound(positions.constBegin(), positions.constEnd(), byteOffset,
+    [](qint64 offset, const GCodePosition & position) {
+        return offset < position.byteOffset;
+    });
+    if (next == positions.constBegin()) {
+        return 0;
+    }
+    const GCodePosition &previous = *(next - 1);
+    const qint64 endOffset = next == positions.constEnd() ? byteCount : next->byteOffset;
+    const qint64 endVertex = next == positions.constEnd() ? vertexCount : next->vertex;
+    if (endOffset <= previous.byteOffset) {
+        return previous.vertex;
+    }
+    const double ratio = double(qMin(byteOffset, endOffset) - previous.byteOffset) / (endOffset - previous.byteOffset);
+    return previous.vertex + qint64((endVertex - previous.vertex) * ratio);
+}
+
+double GCodeMetadata::vertexAtTime(double time) const
+{
+    auto next = std::upper_bound(times.constBegin(), times.constEnd(), float(time));
+    if (next == times.constBegin()) {
+        return 0;
+    }
+    // Linear between two known times, the move to a timed vertex starts from the vertex before it
+    const qint64 index = next - times.constBegin();
+    const double startTime = *(next - 1);
+    const qint64 startVertex = qMax<qint64>((index - 1) * timeInterval - 1, 0);
+    const double endTime = next == times.constEnd() ? printTime : *next;
+    const qint64 endVertex = (next == times.constEnd() ? vertexCount : index * timeInterval) - 1;
+    if (endTime <= startTime) {
+        return startVertex;
+    }
+    return startVertex + (endVertex - startVertex) * qMin((time - startTime) / (endTime - startTime), 1.0);
+}
+
+qint64 GCodeMetadata::sourceLine(qint64 vertex, const char *data, qint64 size) const
+{
+    if (vertex < 0 || vertex >= vertexCount) {
+        return -1;
+    }
+    auto next = std::upper_bound(positions.constBegin(), positions.constEnd(), vertex,
+    [](qint64 value, const GCodePosition & position) {
+        return value < position.vertex;
+    });
+    if (next == positions.constBegin()) {
+        return -1;
+    }
+
+    // Every line from the position on, until the one whose vertices reach vertex
+    const GCodePosition &position = *(next - 1);
+    qint64 line = position.line;
+    qint64 lineVertex = position.vertex;
+    auto arc = std::lower_bound(arcs.constBegin(), arcs.constEnd(), lineVertex, [](const GCodeArc & value, qint64 first) {
+        return value.vertex < first;
+    });
+    const char *end = data + size;
+    for (const char *begin = data + position.byteOffset; begin < end; ++line) {
+        const char *lineEnd = GCodeTokenizer::findLineEnd(begin, end);
+        int count = GCodeParser::vertexCount(begin, lineEnd);
+        if (count > 0 && arc != arcs.constEnd() && arc->vertex == lineVertex) {
+            count = arc->vertexCount;
+            ++arc;
+        }
+        lineVertex += count;
+        if (lineVertex > vertex) {
+            return line;
+        }
+        begin = lineEnd + 1;
+    }
+    return -1;
+}
+
+void GCodeMetadata::growBox(const QVector4D &vertex)
+{
+    const QVector3D position = vertex.toVector3D() * _mmPerUnit;
+    if (!_hasExtrusion) {
+        minimum = position;
+        maximum = position;
+        _hasExtrusion = true;
+        return;
+    }
+    minimum = QVector3D(qMin(minimum.x(), position.x()), qMin(minimum.y(), position.y()), qMin(minimum.z(), position.z()));
+    maximum = QVector3D(qMax(maximum.x(), position.x()), qMax(maximum.y(), position.y()), qMax(maximum.z(), position.z()));
+}
+
+void GCodeMetadata::closeLayer(qint64 end)
+{
+    if (!layers.isEmpty()) {
+        layers.last().vertexCount = end - layers.last().vertexOffset;
+    }
+}
+
+QByteArray GCodeMetadata::toByteArray() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << _streamVersion << minimum << maximum << filament
+           << moveCount << arcCount << extrusionCount << travelCount << vertexCount << byteCount << lineCount
+           << printTime << maxFeedRate << qint32(layers.size()) << qint32(positions.size()) << qint32(features.size())
+           << qint32(arcs.size());
+    for (const GCodeLayer &layer : layers) {
+        stream << layer.z << layer.byteOffset << layer.vertexOffset << layer.vertexCount << layer.filament << layer.time;
+    }
+    for (const GCodePosition &position : positions) {
+        stream << position.byteOffset << position.line << position.vertex << position.time;
+    }
+    for (const GCodeFeature &feature : features) {
+        stream << feature.vertex << quint8(feature.feature);
+    }
+    for (const GCodeArc &arc : arcs) {
+        stream << arc.vertex << arc.vertexCount;
+    }
+    stream << quint32(times.size());
+    for (float time : times) {
+        stream << time;
+    }
+    return data;
+}
+
+GCodeMetadata GCodeMetadata::fromByteArray(const QByteArray &data)
+{
+    GCodeMetadata metadata;
+    QDataStream stream(data);
+    quint32 version = 0;
+    qint32 layerCount = 0;
+    qint32 positionCount = 0;
+    qint32 featureCount = 0;
+    qint32 arcLineCount = 0;
+    quint32 timeCount = 0;
+    stream >> version;
+    if (version != _streamVersion) {
+        return GCodeMetadata();
+    }
+    stream >> metadata.minimum >> metadata.maximum >> metadata.filament
+           >> metadata.moveCount >> metadata.arcCount >> metadata.extrusionCount >> metadata.travelCount
+           >> metadata.vertexCount >> metadata.byteCount >> metadata.lineCount >> metadata.printTime >> metadata.maxFeedRate
+           >> layerCount >> positionCount >> featureCount >> arcLineCount;
+    if (stream.status() != QDataStream::Ok || layerCount < 0 || positionCount < 0 || featureCount < 0 || arcLineCount < 0
+            || layerCount * _layerSize + positionCount * _positionSize + featureCount * _featureSize + arcLineCount * _arcSize
+            > remaining(stream, data)) {
+        return GCodeMetadata();
+    }
+    metadata.layers.resize(layerCount);
+    for (GCodeLayer &layer : metadata.layers) {
+        stream >> layer.z >> layer.byteOffset >> layer.vertexOffset >> layer.vertexCount >> layer.filament >> layer.time;
+    }
+    metadata.positions.resize(positionCount);
+    for (GCodePosition &position : metadata.positions) {
+        stream >> position.byteOffset >> position.line >> position.vertex >> position.time;
+    }
+    metadata.features.resize(featureCount);
+    for (GCodeFeature &feature : metadata.features) {
+        quint8 value = 0;
+        stream >> feature.vertex >> value;
+        feature.feature = GCodeParser::Feature(qMin<quint8>(value, GCodeParser::OtherFeature));
+    }
+    metadata.arcs.resize(arcLineCount);
+    for (GCodeArc &arc : metadata.arcs) {
+        stream >> arc.vertex >> arc.vertexCount;
+    }
+    stream >> timeCount;
+    if (stream.status() != QDataStream::Ok || timeCount * _timeSize > remaining(stream, data)) {
+        return GCodeMetadata();
+    }
+    metadata.times.resize(int(timeCount));
+    for (float &time : metadata.times) {
+        stream >> time;
+    }
+    metadata._hasExtrusion = metadata.extrusionCount > 0;
+    return stream.status() == QDataStream::Ok ? metadata : GCodeMetadata();
+}
@@ -0,0 +1,130 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QVector>
+#include <QVector3D>
+#include <QVector4D>
+#include "gcodeparser.h"
+
+// A layer starts at the first extruding move done at a new height, at least half the first layer height
+// away from the previous layer.
+// byteOffset is the position in the file of the line that moved to that height,
+// vertexOffset and vertexCount are the layer range in the geometry.
+struct GCodeLayer {
+    float z = 0;
+    qint64 byteOffset = 0;
+    qint64 vertexOffset = 0;
+    qint64 vertexCount = 0;
+    // Net filament pushed by the layer, mm
+    double filament = 0;
+    // Estimated time when the layer starts, s
+    double time = 0;
+};
+
+// First vertex at or after a byte offset of the file, and the estimated time when its move starts.
+// line is the line of byteOffset, counted from 0.
+struct GCodePosition {
+    qint64 byteOffset = 0;
+    qint64 line = 0;
+    qint64 vertex = 0;
+    float time = 0;
+};
+
+// First vertex of the moves of a slicer feature
+struct GCodeFeature {
+    qint64 vertex = 0;
+    GCodeParser::Feature feature = GCodeParser::UnknownFeature;
+};
+
+// G2/G3 line drawn with more than one chord
+struct GCodeArc {
+    qint64 vertex = 0;
+    qint32 vertexCount = 0;
+};
+
+// Statistics and layer table of a G-code file, built from the parsed chunks.
+// Lengths are in mm.
+class GCodeMetadata
+{
+public:
+    QVector<GCodeLayer> layers;
+    // About every GCodeParser::positionInterval bytes
+    QVector<GCodePosition> positions;
+    // Every feature change, in file order
+    QVector<GCodeFeature> features;
+    QVector<GCodeArc> arcs;
+    // Estimated time when the move ending on every timeInterval-th vertex starts, s
+    QVector<float> times;
+    // Bounding box of the extruding moves
+    QVector3D minimum;
+    QVector3D maximum;
+    // Net filament, retractions included
+    double filament = 0;
+    qint64 moveCount = 0;
+    qint64 arcCount = 0;
+    // Drawn segments, arcs count once per chord
+    qint64 extrusionCount = 0;
+    qint64 travelCount = 0;
+    qint64 vertexCount = 0;
+    qint64 byteCount = 0;
+    qint64 lineCount = 0;
+    // Fastest extruding move, mm/s
+    float maxFeedRate = 0;
+    // Estimated print time in s, see PrintTimeEstimator
+    double printTime = 0;
+
+    // Adds a resolved chunk, chunks must be added in file order
+    void add(const GCodeParser::Chunk &chunk, qint64 chunkOffset);
+    // Closes the last layer
+    void finish();
+    // Sets printTime once the times of the positions are known, and the layer times from them
+    void setPrintTime(double time);
+    // Estimated time when the line at byteOffset is reached
+    double timeAt(qint64 byteOffset) const;
+    // Vertex reached when the file is read up to byteOffset, interpolated between two positions
+    qint64 vertexAt(qint64 byteOffset) const;
+    // Last vertex reached at an estimated time, plus the fraction of the move to the next one done
+    double vertexAtTime(double time) const;
+    // Line, counted from 0, of the move that ends on vertex, -1 if there is none.
+    // data is the whole file, only the lines after the closest position are read again.
+    qint64 sourceLine(qint64 vertex, const char *data, qint64 size) const;
+
+    QByteArray toByteArray() const;
+    static GCodeMetadata fromByteArray(const QByteArray &data);
+
+    static const int timeInterval = 128;
+
+private:
+    void growBox(const QVector4D &vertex);
+    void closeLayer(qint64 end);
+
+    // Last vertex added, start of the next move
+    QVector4D _previous;
+    // Line and vertex where the current height was reached
+    qint64 _heightOffset = 0;
+    qint64 _heightVertex = 0;
+    bool _hasExtrusion = false;
+};
+
+Q_DECLARE_METATYPE(GCodeMetadata)
@@ -0,0 +1,565 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <cstring>
+#include <QByteArray>
+#include "gcodeparser.h"
+#include "gcodetokenizer.h"
+#include "scankernels.h"
+
+namespace
+{
+const char _axisLetters[GCodeParser::AxisCount] = {'X', 'Y', 'Z', 'E'};
+// Average bytes per move line, used to reserve vertex memory up front
+const int _bytesPerMove = 24;
+// Positions are integer nanometres, vertices are in cm
+const double _unitsPerMm = 1e6;
+const double _unitsPerInch = 25.4e6;
+const double _vertexScale = 1e-7;
+const int _maxArcSegments = 1024;
+const double _pi = 3.14159265358979323846;
+// Lines between two checks of the cancel flag
+const int _cancelCheckLines = 4096;
+const char _featurePrefix[] = ";TYPE:";
+const int _featurePrefixSize = sizeof(_featurePrefix) - 1;
+
+struct FeatureName {
+    const char *name;
+    GCodeParser::Feature feature;
+};
+
+// Cura names first, then PrusaSlicer ones
+const FeatureName _featureNames[] = {
+    {"WALL-OUTER", GCodeParser::OuterWall},
+    {"WALL-INNER", GCodeParser::InnerWall},
+    {"SKIN", GCodeParser::Skin},
+    {"FILL", GCodeParser::Infill},
+    {"SUPPORT", GCodeParser::Support},
+    {"SUPPORT-INTERFACE", GCodeParser::Support},
+    {"SKIRT", GCodeParser::SkirtBrim},
+    {"External perimeter", GCodeParser::OuterWall},
+    {"Overhang perimeter", GCodeParser::OuterWall},
+    {"Perimeter", GCodeParser::InnerWall},
+    {"Solid infill", GCodeParser::Skin},
+    {"Top solid infill", GCodeParser::Skin},
+    {"Bridge infill", GCodeParser::Skin},
+    {"Ironing", GCodeParser::Skin},
+    {"Internal infill", GCodeParser::Infill},
+    {"Gap fill", GCodeParser::Infill},
+    {"Support material", GCodeParser::Support},
+    {"Support material interface", GCodeParser::Support},
+    {"Skirt/Brim", GCodeParser::SkirtBrim},
+    {"Skirt", GCodeParser::SkirtBrim},
+    {"Brim", GCodeParser::SkirtBrim},
+};
+
+inline float toVertex(qint64 value)
+{
+    return float(double(value) * _vertexScale);
+}
+
+inline qint64 entryValue(const GCodeParser::State &entry, GCodeParser::Source source, int axis)
+{
+    switch (source) {
+    case GCodeParser::EntryPosition:
+        return entry.position[axis].local;
+    case GCodeParser::EntryOffset:
+        return entry.offset[axis].local;
+    default:
+        return 0;
+    }
+}
+
+inline GCodeParser::Value resolved(const GCodeParser::Value &value, const GCodeParser::State &entry, int axis)
+{
+    GCodeParser::Value result;
+    result.local = value.local + entryValue(entry, value.source, axis);
+    return result;
+}
+
+// Interprets the lines of a single chunk
+class Interpreter
+{
+public:
+    Interpreter(GCodeParser::Chunk &chunk, const GCodeParser::Options &options) :
+        _chunk(chunk)
+        , _modal(chunk.entryModal)
+        , _arcTolerance(double(options.arcTolerance) * _unitsPerMm)
+        , _canceled(options.canceled)
+        // A known entry without feed rate is the start of the file
+        , _feedRate(!chunk.entryKnown ? -1 : chunk.entryFeedRate < 0 ? options.defaultFeedRate : chunk.entryFeedRate)
+    {
+        for (int axis = 0; axis < GCodeParser::AxisCount; ++axis) {
+            if (chunk.entryKnown) {
+                _state.position[axis] = resolved(chunk.entry.position[axis], chunk.entry, axis);
+                _state.offset[axis] = resolved(chunk.entry.offset[axis], chunk.entry, axis);
+            } else {
+                _state.position[axis].source = GCodeParser::EntryPosition;
+                _state.offset[axis].source = GCodeParser::EntryOffset;
+            }
+        }
+        updateUnits();
+    }
+
+    void run()
+    {
+        _chunk.vertices.clear();
+        _chunk.vertices.reserve(int((_chunk.end - _chunk.begin) / _bytesPerMove));
+        _chunk.pending.clear();
+        _chunk.needsReparse = false;
+        _chunk.marks.clear();
+        _chunk.positions.clear();
+        _chunk.features.clear();
+        _chunk.arcs.clear();
+        _chunk.feedRates.clear();
+        _chunk.feedRates.reserve(_chunk.vertices.capacity());
+        _chunk.moveCount = 0;
+        _chunk.arcCount = 0;
+        _lineNumber = 0;
+
+        const ScanKernels::Kernels &kernels = ScanKernels::kernels();
+        GCodeTokenizer::Words words;
+        char command;
+        int code;
+        int lineCount = 0;
+        for (const char *line = _chunk.begin; line < _chunk.end;) {
+            if (_canceled && ++lineCount == _cancelCheckLines) {
+                if (_canceled->load()) {
+                    break;
+                }
+                lineCount = 0;
+            }
+            const char *lineEnd = kernels.findLineEndOrComment(line, _chunk.end);
+            const char *commandEnd = lineEnd;
+            if (lineEnd < _chunk.end && *lineEnd == ';') {
+                const char *comment = lineEnd;
+                lineEnd = kernels.findLineEnd(lineEnd, _chunk.end);
+                if (lineEnd - comment > _featurePrefixSize && memcmp(comment, _featurePrefix, _featurePrefixSize) == 0) {
+                    addFeature(GCodeParser::feature(comment + _featurePrefixSize, lineEnd));
+                }
+            }
+
+            if (GCodeTokenizer::parseLine(line, commandEnd, command, code, words, kernels.parseNumber)) {
+                _line = line;
+                _movesZ = words.has('Z');
+                if (command == 'G') {
+                    gCommand(code, words);
+                } else if (command == 'M') {
+                    mCommand(code);
+                }
+            }
+
+            line = lineEnd < _chunk.end ? lineEnd + 1 : _chunk.end;
+            ++_lineNumber;
+        }
+
+        _chunk.exit = _state;
+        _chunk.lineCount = _lineNumber;
+        _chunk.exitModal = _modal;
+        _chunk.exitFeedRate = _feedRate;
+    }
+
+private:
+    typedef GCodeParser::Value Value;
+
+    // Difference of two values: local + entry(plus) - entry(minus)
+    struct Delta {
+        qint64 local;
+        GCodeParser::Source plus;
+        GCodeParser::Source minus;
+        bool isKnown() const
+        {
+            return plus == GCodeParser::Known && minus == GCodeParser::Known;
+        }
+    };
+
+    GCodeParser::Chunk &_chunk;
+    GCodeParser::Modal _modal;
+    GCodeParser::State _state;
+    double _unitScale = _unitsPerMm;
+    double _arcTolerance;
+    const QAtomicInt *_canceled;
+    float _feedRate;
+    // Line being interpreted and whether its next vertex must be marked
+    const char *_line = nullptr;
+    int _lineNumber = 0;
+    bool _movesZ = false;
+    qint64 _nextPosition = 0;
+
+    void updateUnits()
+    {
+        _unitScale = _modal.inches ? _unitsPerInch : _unitsPerMm;
+    }
+
+    qint64 toUnits(float value) const
+    {
+        return qint64(std::llround(double(value) * _unitScale));
+    }
+
+    static Delta difference(const Value &a, const Value &b)
+    {
+        Delta delta;
+        delta.local = a.local - b.local;
+        delta.plus = a.source == b.source ? GCodeParser::Known : a.source;
+        delta.minus = a.source == b.source ? GCodeParser::Known : b.source;
+        return delta;
+    }
+
+    void gCommand(int code, const GCodeTokenizer::Words &words)
+    {
+        switch (code) {
+        case 0:
+        case 1:
+            ++_chunk.moveCount;
+            updateFeedRate(words);
+            move(words);
+            break;
+        case 2:
+        case 3:
+            ++_chunk.moveCount;
+            updateFeedRate(words);
+            ++_chunk.arcCount;
+            arc(words, code == 2);
+            break;
+        case 20:
+        case 21:
+            _modal.inches = code == 20;
+            updateUnits();
+            break;
+        case 28:
+            home(words);
+            break;
+        case 90:
+        case 91:
+            _modal.relative = code == 91;
+            _modal.relativeExtrusion = code == 91;
+            break;
+        case 92:
+            setPosition(words);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void mCommand(int code)
+    {
+        if (code == 82 || code == 83) {
+            _modal.relativeExtrusion = code == 83;
+        }
+    }
+
+    void updateFeedRate(const GCodeTokenizer::Words &words)
+    {
+        // F is in units per minute
+        if (words.has('F')) {
+            _feedRate = float(double(words['F']) * _unitScale / _unitsPerMm / 60);
+        }
+    }
+
+    // Position reached by a G0/G1/G2/G3 with these words
+    void target(const GCodeTokenizer::Words &words, Value *position) const
+    {
+        for (int axis = 0; axis < GCodeParser::AxisCount; ++axis) {
+            position[axis] = _state.position[axis];
+            if (!words.has(_axisLetters[axis])) {
+                continue;
+            }
+            const qint64 value = toUnits(words[_axisLetters[axis]]);
+            const bool relative = axis == GCodeParser::E ? _modal.relativeExtrusion : _modal.relative;
+            if (relative) {
+                position[axis].local += value;
+            } else {
+                position[axis].local = _state.offset[axis].local + value;
+                position[axis].source = _state.offset[axis].source;
+            }
+        }
+    }
+
+    void move(const GCodeTokenizer::Words &words)
+    {
+        Value position[GCodeParser::AxisCount];
+        target(words, position);
+        const Delta extruded = difference(position[GCodeParser::E], _state.position[GCodeParser::E]);
+        for (int axis = 0; axis < GCodeParser::AxisCount; ++axis) {
+            _state.position[axis] = position[axis];
+        }
+        addVertex(position, extruded);
+    }
+
+    // G2/G3 in the XY plane, with a center offset (I, J) or a radius (R).
+    // Everything is computed relative to the start point so the chords do not depend on the chunk entry.
+    void arc(const GCodeTokenizer::Words &words, bool clockwise)
+    {
+        const Value *start = _state.position;
+        Value end[GCodeParser::AxisCount];
+        target(words, end);
+        const Delta extruded = difference(end[GCodeParser::E], start[GCodeParser::E]);
+        if (end[GCodeParser::X].source != start[GCodeParser::X].source
+                || end[GCodeParser::Y].source != start[GCodeParser::Y].source
+                || end[GCodeParser::Z].source != start[GCodeParser::Z].source
+                || !extruded.isKnown()) {
+            _chunk.needsReparse = true;
+            for (int axis = 0; axis < GCodeParser::AxisCount; ++axis) {
+                _state.position[axis] = end[axis];
+            }
+            return;
+        }
+
+        const double dx = double(end[GCodeParser::X].local - start[GCodeParser::X].local);
+        const double dy = double(end[GCodeParser::Y].local - start[GCodeParser::Y].local);
+        double ci = words.has('I') ? double(toUnits(words['I'])) : 0;
+        double cj = words.has('J') ? double(toUnits(words['J'])) : 0;
+        if (words.has('R') && (dx != 0 || dy != 0)) {
+            // Center on the perpendicular bisector of the chord, same maths as Marlin
+            const double r = double(toUnits(words['R']));
+            const double mx = dx / 2;
+            const double my = dy / 2;
+            const double length = std::sqrt(mx * mx + my * my);
+            const double h2 = (r - length) * (r + length);
+            const double h = h2 > 0 ? std::sqrt(h2) : 0;
+            const double direction = (clockwise != (r < 0)) ? -1 : 1;
+            ci = mx - my / length * direction * h;
+            cj = my + mx / length * direction * h;
+        }
+        const double radius = std::sqrt(ci * ci + cj * cj);
+        if (radius == 0) {
+            move(words);
+            return;
+        }
+
+        // Vectors from the center to the start and end points
+        const double ax = -ci;
+        const double ay = -cj;
+        const double bx = dx - ci;
+        const double by = dy - cj;
+        double sweep = std::atan2(ax * by - ay * bx, ax * bx + ay * by);
+        if (sweep < 0) {
+            sweep += 2 * _pi;
+        }
+        if (dx == 0 && dy == 0) {
+            sweep = clockwise ? -2 * _pi : 2 * _pi;
+        } else if (clockwise) {
+            sweep -= 2 * _pi;
+        }
+
+        // Largest angle whose chord stays within the tolerance, sagitta = r * (1 - cos(angle / 2))
+        double maxAngle = _pi / 2;
+        if (_arcTolerance < radius) {
+            maxAngle = qMin(maxAngle, 2 * std::acos(1 - _arcTolerance / radius));
+        }
+        const int segments = qBound(1, int(std::ceil(std::abs(sweep) / maxAngle)), _maxArcSegments);
+
+        const double startAngle = std::atan2(ay, ax);
+        const qint64 dz = end[GCodeParser::Z].local - start[GCodeParser::Z].local;
+        if (segments > 1) {
+            GCodeParser::ArcMark mark = {_chunk.vertices.size(), segments};
+            _chunk.arcs.append(mark);
+        }
+        Value point[GCodeParser::AxisCount];
+        qint64 extrudedSoFar = 0;
+        for (int i = 1; i <= segments; ++i) {
+            for (int axis = 0; axis < GCodeParser::AxisCount; ++axis) {
+                point[axis] = end[axis];
+            }
+            if (i < segments) {
+                const double angle = startAngle + sweep * i / segments;
+                point[GCodeParser::X].local = start[GCodeParser::X].local + std::llround(ci + radius * std::cos(angle));
+                point[GCodeParser::Y].local = start[GCodeParser::Y].local + std::llround(cj + radius * std::sin(angle));
+                point[GCodeParser::Z].local = start[GCodeParser::Z].local + dz * i / segments;
+            }
+            Delta part = extruded;
+            part.local = extruded.local * i / segments - extrudedSoFar;
+            extrudedSoFar += part.local;
+            addVertex(point, part);
+        }
+
+        for (int axis = 0; axis < GCodeParser::AxisCount; ++axis) {
+            _state.position[axis] = end[axis];
+        }
+    }
+
+    void home(const GCodeTokenizer::Words &words)
+    {
+        const bool all = !words.has('X') && !words.has('Y') && !words.has('Z');
+        _movesZ = all || words.has('Z');
+        for (int axis = GCodeParser::X; axis <= GCodeParser::Z; ++axis) {
+            if (all || words.has(_axisLetters[axis])) {
+                _state.position[axis] = Value();
+                _state.offset[axis] = Value();
+            }
+        }
+        Delta extruded = {0, GCodeParser::Known, GCodeParser::Known};
+        addVertex(_state.position, extruded);
+    }
+
+    // G92, without words every axis is set to zero
+    void setPosition(const GCodeTokenizer::Words &words)
+    {
+        const bool all = !(words.mask & (GCodeTokenizer::Words::bit('X') | GCodeTokenizer::Words::bit('Y')
+                                         | GCodeTokenizer::Words::bit('Z') | GCodeTokenizer::Words::bit('E')));
+        for (int axis = 0; axis < GCodeParser::AxisCount; ++axis) {
+            if (!all && !words.has(_axisLetters[axis])) {
+                continue;
+            }
+            const qint64 value = all ? 0 : toUnits(words[_axisLetters[axis]]);
+            _state.offset[axis].local = _state.position[axis].local - value;
+            _state.offset[axis].source = _state.position[axis].source;
+        }
+    }
+
+    void addFeature(GCodeParser::Feature feature)
+    {
+        const int vertex = _chunk.vertices.size();
+        if (!_chunk.features.isEmpty() && _chunk.features.last().vertex == vertex) {
+            _chunk.features.last().feature = feature;
+            return;
+        }
+        GCodeParser::FeatureMark mark = {vertex, feature};
+        _chunk.features.append(mark);
+    }
+
+    void addVertex(const Value *position, const Delta &extruded)
+    {
+        const int index = _chunk.vertices.size();
+        if (_movesZ || index == 0) {
+            GCodeParser::Mark mark = {index, qint64(_line - _chunk.begin), _lineNumber, _movesZ};
+            _chunk.marks.append(mark);
+            _movesZ = false;
+        }
+        const qint64 offset = _line - _chunk.begin;
+        if (offset >= _nextPosition) {
+            GCodeParser::Mark position = {index, offset, _lineNumber, false};
+            _chunk.positions.append(position);
+            _nextPosition = offset - offset % GCodeParser::positionInterval + GCodeParser::positionInterval;
+        }
+        _chunk.feedRates.append(_feedRate);
+        QVector4D vertex;
+        for (int axis = GCodeParser::X; axis <= GCodeParser::Z; ++axis) {
+            vertex[axis] = toVertex(position[axis].local);
+            if (position[axis].source != GCodeParser::Known) {
+                GCodeParser::Pending pending = {index, qint8(axis), position[axis].source, GCodeParser::Known, position[axis].local};
+                _chunk.pending.append(pending);
+            }
+        }
+        vertex[GCodeParser::E] = toVertex(extruded.local);
+        if (!extruded.isKnown()) {
+            GCodeParser::Pending pending = {index, qint8(GCodeParser::E), extruded.plus, extruded.minus, extruded.local};
+            _chunk.pending.append(pending);
+        }
+        _chunk.vertices.append(vertex);
+    }
+};
+}
+
+QVector<GCodeParser::Chunk> GCodeParser::split(const char *begin, const char *end, qint64 chunkSize, qint64 firstChunkSize)
+{
+    QVector<Chunk> chunks;
+    const char *chunkBegin = begin;
+    while (chunkBegin < end) {
+        const qint64 size = chunks.isEmpty() && firstChunkSize > 0 ? firstChunkSize : chunkSize;
+        const char *chunkEnd = end;
+        if (end - chunkBegin > size) {
+            chunkEnd = GCodeTokenizer::findLineEnd(chunkBegin + size, end);
+            chunkEnd = chunkEnd < end ? chunkEnd + 1 : end;
+        }
+        Chunk chunk;
+        chunk.begin = chunkBegin;
+        chunk.end = chunkEnd;
+        chunks.append(chunk);
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+void GCodeParser::parse(Chunk &chunk, const Options &options)
+{
+    Interpreter(chunk, options).run();
+}
+
+void GCodeParser::stitch(Chunk &chunk, const Chunk *previous, const Options &options)
+{
+    // A file starts at the origin, in absolute mm
+    chunk.entry = previous ? previous->exit : State();
+    chunk.entryFeedRate = previous ? previous->exitFeedRate : options.defaultFeedRate;
+    const Modal modal = previous ? previous->exitModal : Modal();
+    if (chunk.entryModal != modal) {
+        chunk.entryModal = modal;
+        chunk.entryKnown = true;
+        parse(chunk, options);
+    } else if (!chunk.entryKnown) {
+        for (int axis = 0; axis < AxisCount; ++axis) {
+            chunk.exit.position[axis] = resolved(chunk.exit.position[axis], chunk.entry, axis);
+            chunk.exit.offset[axis] = resolved(chunk.exit.offset[axis], chunk.entry, axis);
+        }
+    }
+    if (chunk.exitFeedRate < 0) {
+        chunk.exitFeedRate = chunk.entryFeedRate;
+    }
+}
+
+void GCodeParser::resolve(Chunk &chunk, const Options &options)
+{
+    if (chunk.needsReparse && !chunk.entryKnown) {
+        chunk.entryKnown = true;
+        parse(chunk, options);
+    }
+
+    QVector4D *vertices = chunk.vertices.data();
+    for (const Pending &pending : chunk.pending) {
+        const qint64 value = pending.local + entryValue(chunk.entry, pending.plus, pending.axis)
+                             - entryValue(chunk.entry, pending.minus, pending.axis);
+        vertices[pending.vertex][pending.axis] = toVertex(value);
+    }
+    chunk.pending = QVector<Pending>();
+
+    // Moves before the first F of the chunk go at the entry feed rate
+    for (float &feedRate : chunk.feedRates) {
+        if (feedRate >= 0) {
+            break;
+        }
+        feedRate = chunk.entryFeedRate;
+    }
+}
+
+GCodeParser::Feature GCodeParser::feature(const char *begin, const char *end)
+{
+    const QByteArray name = QByteArray(begin, int(end - begin)).trimmed();
+    for (const FeatureName &featureName : _featureNames) {
+        if (qstricmp(name.constData(), featureName.name) == 0) {
+            return featureName.feature;
+        }
+    }
+    return name.isEmpty() ? UnknownFeature : OtherFeature;
+}
+
+int GCodeParser::vertexCount(const char *begin, const char *end)
+{
+    const ScanKernels::Kernels &kernels = ScanKernels::kernels();
+    GCodeTokenizer::Words words;
+    char command;
+    int code;
+    if (!GCodeTokenizer::parseLine(begin, kernels.findLineEndOrComment(begin, end), command, code, words, kernels.parseNumber)
+            || command != 'G') {
+        return 0;
+    }
+    return (code >= 0 && code <= 3) || code == 28 ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QAtomicInt>
+#include <QVector>
+#include <QVector4D>
+
+// Modal G-code interpreter, turns G-code text into vertices.
+// A vertex holds X, Y, Z and, in w, the filament extruded by the move that ends on it.
+//
+// A file is cut in newline aligned chunks that can be interpreted independently.
+// Positions are kept as integer nanometres so they can be moved from one origin to
+// another without any rounding: until a chunk assigns an axis the axis stays relative
+// to the chunk entry, stitch() resolves the entries once every chunk is done.
+class GCodeParser
+{
+public:
+    enum Axis {
+        X = 0,
+        Y,
+        Z,
+        E,
+        AxisCount
+    };
+
+    struct Options {
+        // Maximum distance between an arc (G2/G3) and its chords, in mm
+        float arcTolerance = 0.01f;
+        // Feed rate until the first F word, mm/s
+        float defaultFeedRate = 25;
+        // Stops the interpretation once set, chunks are left incomplete
+        const QAtomicInt *canceled = nullptr;
+    };
+
+    struct Modal {
+        bool relative = false;          // G91
+        bool relativeExtrusion = false; // M83
+        bool inches = false;            // G20
+        bool operator==(const Modal &other) const
+        {
+            return relative == other.relative && relativeExtrusion == other.relativeExtrusion && inches == other.inches;
+        }
+        bool operator!=(const Modal &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    // What a value is relative to while the chunk entry is unknown
+    enum Source : qint8 {
+        Known = 0,
+        EntryPosition,
+        EntryOffset
+    };
+
+    struct Value {
+        qint64 local = 0;
+        Source source = Known;
+    };
+
+    // Machine position and G92 offset (machine - logical) of every axis
+    struct State {
+        Value position[AxisCount];
+        Value offset[AxisCount];
+    };
+
+    // Vertex component waiting for the entry: local + entry(plus) - entry(minus)
+    struct Pending {
+        int vertex;
+        qint8 axis;
+        Source plus;
+        Source minus;
+        qint64 local;
+    };
+
+    // Slicer feature of the moves, from the ;TYPE: comments of Cura, PrusaSlicer and their forks
+    enum Feature : quint8 {
+        UnknownFeature = 0,
+        OuterWall,
+        InnerWall,
+        Skin,
+        Infill,
+        Support,
+        SkirtBrim,
+        OtherFeature,
+        FeatureCount
+    };
+
+    // Feature of the moves from vertex on
+    struct FeatureMark {
+        int vertex;
+        Feature feature;
+    };
+
+    // Vertex that may start a layer, offset is the position of its line from the chunk begin
+    struct Mark {
+        int vertex;
+        qint64 offset;
+        // Line of offset, counted from the chunk begin
+        int line;
+        // False for the first vertex of a chunk when its line does not move Z
+        bool movesZ;
+    };
+
+    // G2/G3 line drawn with more than one chord, vertexCount vertices from vertex on
+    struct ArcMark {
+        int vertex;
+        int vertexCount;
+    };
+
+    struct Chunk {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        QVector<QVector4D> vertices;
+        // Parsed assuming entryModal, exact when entryKnown
+        Modal entryModal;
+        Modal exitModal;
+        bool entryKnown = false;
+        State entry;
+        State exit;
+        QVector<Pending> pending;
+        // Arcs starting from an unknown position can only be drawn with a known entry
+        bool needsReparse = false;
+        // The first vertex and every vertex reached by a line that moves Z
+        QVector<Mark> marks;
+        // The first vertex after every positionInterval bytes
+        QVector<Mark> positions;
+        // Every ;TYPE: comment, with the first vertex after it
+        QVector<FeatureMark> features;
+        QVector<ArcMark> arcs;
+        // Feed rate of the move ending on every vertex in mm/s, negative until the chunk sets one
+        QVector<float> feedRates;
+        float entryFeedRate = -1;
+        float exitFeedRate = -1;
+        // G0/G1/G2/G3 lines, and G2/G3 lines alone
+        qint64 moveCount = 0;
+        qint64 arcCount = 0;
+        int lineCount = 0;
+    };
+
+    // Bytes between two entries of Chunk::positions
+    static const qint64 positionInterval = 16 * 1024;
+
+    // Cuts [begin, end) in chunks of about chunkSize bytes, every chunk ends after a '\n'.
+    // A positive firstChunkSize gives the first chunk its own size.
+    static QVector<Chunk> split(const char *begin, const char *end, qint64 chunkSize, qint64 firstChunkSize = 0);
+    static void parse(Chunk &chunk, const Options &options);
+    // Serial pass, called on parsed chunks in file order, previous is nullptr for the first chunk.
+    // Fills the entry and makes the exit known, a chunk parsed with a wrong modal assumption is parsed again.
+    static void stitch(Chunk &chunk, const Chunk *previous, const Options &options);
+    // Resolves the pending vertex components, can run in parallel after stitch()
+    static void resolve(Chunk &chunk, const Options &options);
+    // Feature named by the text after ;TYPE:
+    static Feature feature(const char *begin, const char *end);
+    // Vertices added by the line [begin, end): one for G0, G1, G2, G3 and G28, none for the others.
+    // Arcs drawn with more chords are in Chunk::arcs.
+    static int vertexCount(const char *begin, const char *end);
+};
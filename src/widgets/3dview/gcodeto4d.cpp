@@ -19,32 +19,123 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <QFile>
-#include <QThread>
+#include <QThreadPool>
 #include <QUrl>
-#include <QVector4D>
 #include <QVariant>
 #include "fileloader.h"
 #include "gcodeto4d.h"
 
+namespace
+{
+// Loads only drive the parsing, the chunks themselves run in the global pool
+const int _maxLoaderThreads = 2;
+
+class LoaderPool : public QThreadPool
+{
+public:
+    LoaderPool()
+    {
+        setMaxThreadCount(_maxLoaderThreads);
+    }
+};
+Q_GLOBAL_STATIC(LoaderPool, loaderPool)
+}
+
 GcodeTo4D::GcodeTo4D(QObject *parent) : QObject(parent)
+    , _loader(nullptr)
+    , _generation(0)
+    , _quantize(true)
 {
 }
 
 GcodeTo4D::~GcodeTo4D()
 {
+    cancel();
 }
 
 void GcodeTo4D::read(const QString &url)
 {
-    _thread = new QThread;
+    cancel();
+
+    const int generation = ++_generation;
     QString path = QUrl(url).path();
-    auto fileLoader = new FileLoader(path);
-    fileLoader->moveToThread(_thread);
-    connect(fileLoader, &FileLoader::percentUpdate, this, &GcodeTo4D::percentUpdate);
-    connect(fileLoader, &FileLoader::posFinished, this, &GcodeTo4D::posFinished);
-    connect(fileLoader, &FileLoader::posFinished, _thread, &QThread::quit);
-    connect(_thread, &QThread::started, fileLoader, &FileLoader::run);
-    connect(_thread, &QThread::finished, fileLoader, &FileLoader::deleteLater);
-    _thread->start();
+    _loader = new FileLoader(path);
+    _loader->setOptions(_options);
+    _loader->setMotionLimits(_limits);
+    _loader->setQuantization(_quantize, _buildVolume);
+    _loader->setAutoDelete(false);
+    connect(_loader, &FileLoader::percentUpdate, this, [this, generation](const QVariant & percent) {
+        if (generation == _generation) {
+            emit percentUpdate(percent);
+        }
+    });
+    connect(_loader, &FileLoader::posBatch, this, [this, generation](const VertexBatch & batch) {
+        if (generation == _generation) {
+            emit posBatch(batch);
+        }
+    });
+    connect(_loader, &FileLoader::metadataFinished, this, [this, generation](const GCodeMetadata & metadata) {
+        if (generation == _generation) {
+            emit metadataFinished(metadata);
+        }
+    });
+    connect(_loader, &FileLoader::posFinished, this, [this, generation] {
+        if (generation == _generation) {
+            _loader = nullptr;
+            emit posFinished();
+        }
+    });
+    connect(_loader, &FileLoader::finished, _loader, &FileLoader::deleteLater);
+    loaderPool()->start(_loader);
+}
+
+void GcodeTo4D::cancel()
+{
+    if (!_loader) {
+        return;
+    }
+    ++_generation;
+    // Not started yet, nothing will ever run it
+    if (loaderPool()->tryTake(_loader)) {
+        delete _loader;
+    } else {
+        _loader->cancel();
+    }
+    _loader = nullptr;
+}
+
+float GcodeTo4D::arcTolerance() const
+{
+    return _options.arcTolerance;
+}
+
+void GcodeTo4D::setArcTolerance(float tolerance)
+{
+    _options.arcTolerance = tolerance;
 }
 
+MotionLimits GcodeTo4D::motionLimits() const
+{
+    return _limits;
+}
+
+void GcodeTo4D::setMotionLimits(const MotionLimits &limits)
+{
+    _limits = limits;
+}
+
+bool GcodeTo4D::quantize() const
+{
+    return _quantize;
+}
+
+QVector3D GcodeTo4D::buildVolume() const
+{
+    return _buildVolume;
+}
+
+void GcodeTo4D::setQuantization(bool quantize, const QVector3D &buildVolume)
+{
+    _quantize = quantize;
+    _buildVolume = buildVolume;
+}
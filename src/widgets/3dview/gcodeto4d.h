@@ -21,6 +21,13 @@
 #pragma once
 
 #include <QObject>
+#include <QVector3D>
+#include "gcodemetadata.h"
+#include "gcodeparser.h"
+#include "printtimeestimator.h"
+#include "vertexbatch.h"
+
+class FileLoader;
 
 class GcodeTo4D : public QObject
 {
@@ -31,13 +38,31 @@ public:
     ~GcodeTo4D();
 
 public:
+    // Latest wins, a load still running for a previous call is canceled
     void read(const QString &url);
+    void cancel();
+    float arcTolerance() const;
+    void setArcTolerance(float tolerance);
+    // Used by the next read() for the print time estimation
+    MotionLimits motionLimits() const;
+    void setMotionLimits(const MotionLimits &limits);
+    // Used by the next read(), see FileLoader::setQuantization()
+    bool quantize() const;
+    QVector3D buildVolume() const;
+    void setQuantization(bool quantize, const QVector3D &buildVolume);
 
 signals:
     void percentUpdate(const QVariant &percent);
-    void posFinished(const QList<QVector4D> &pos);
+    void posBatch(const VertexBatch &batch);
+    void metadataFinished(const GCodeMetadata &metadata);
+    void posFinished();
 
 private:
-    QThread *_thread;
-    bool _wait;
+    FileLoader *_loader;
+    // Signals of superseded loads carry an old generation and are dropped
+    int _generation;
+    GCodeParser::Options _options;
+    MotionLimits _limits;
+    bool _quantize;
+    QVector3D _buildVolume;
 };
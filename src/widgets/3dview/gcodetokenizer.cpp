@@ -0,0 +1,130 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "gcodetokenizer.h"
+
+namespace
+{
+// Powers of ten that are exact in a double.
+const double _pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int _maxPow10 = 22;
+const uint64_t _mantissaLimit = 100000000000000000ULL;
+
+inline bool isDigit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline char toUpper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+}
+}
+
+bool GCodeTokenizer::parseNumber(const char *&p, const char *end, float &value)
+{
+    const char *s = p;
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        ++s;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; s < end && isDigit(*s); ++s) {
+        hasDigits = true;
+        if (mantissa < _mantissaLimit) {
+            mantissa = mantissa * 10 + (*s - '0');
+        } else {
+            ++exponent;
+        }
+    }
+    if (s < end && *s == '.') {
+        for (++s; s < end && isDigit(*s); ++s) {
+            hasDigits = true;
+            if (mantissa < _mantissaLimit) {
+                mantissa = mantissa * 10 + (*s - '0');
+                --exponent;
+            }
+        }
+    }
+    if (!hasDigits) {
+        return false;
+    }
+
+    double result = static_cast<double>(mantissa);
+    while (exponent < -_maxPow10) {
+        result /= _pow10[_maxPow10];
+        exponent += _maxPow10;
+    }
+    while (exponent > _maxPow10) {
+        result *= _pow10[_maxPow10];
+        exponent -= _maxPow10;
+    }
+    result = exponent < 0 ? result / _pow10[-exponent] : result * _pow10[exponent];
+
+    value = static_cast<float>(negative ? -result : result);
+    p = s;
+    return true;
+}
+
+bool GCodeTokenizer::parseLine(const char *begin, const char *end, char &command, int &code, Words &words,
+                               NumberParser numberParser)
+{
+    command = 0;
+    code = -1;
+    words.mask = 0;
+
+    const char *p = begin;
+    while (p < end) {
+        const char letter = toUpper(*p);
+        if (letter < 'A' || letter > 'Z') {
+            // Checksum, nothing useful after it
+            if (*p == '*') {
+                break;
+            }
+            ++p;
+            continue;
+        }
+
+        ++p;
+        float value;
+        const bool hasValue = numberParser(p, end, value);
+        if (!hasValue) {
+            // Bare words like the X of "G28 X" are flags, they read as 0
+            value = 0;
+        }
+
+        if (!command && hasValue && (letter == 'G' || letter == 'M' || letter == 'T')) {
+            command = letter;
+            code = static_cast<int>(value);
+            continue;
+        }
+        words.value[letter - 'A'] = value;
+        words.mask |= Words::bit(letter);
+    }
+
+    return command || words.mask;
+}
@@ -0,0 +1,70 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Byte level G-code scanning.
+// Everything here works on raw [begin, end) ranges, usually a QFile::map()ed view,
+// does not depend on the locale and never allocates.
+namespace GCodeTokenizer
+{
+
+// Words of a single line, indexed by letter - 'A'.
+struct Words {
+    uint32_t mask = 0;
+    float value[26];
+
+    static constexpr uint32_t bit(char letter)
+    {
+        return 1u << (letter - 'A');
+    }
+    bool has(char letter) const
+    {
+        return mask & bit(letter);
+    }
+    float operator[](char letter) const
+    {
+        return value[letter - 'A'];
+    }
+};
+
+// Pointer to the next '\n' in [begin, end) or end.
+inline const char *findLineEnd(const char *begin, const char *end)
+{
+    auto p = static_cast<const char *>(memchr(begin, '\n', end - begin));
+    return p ? p : end;
+}
+
+// Parses a plain decimal number ("-12.345", "+.5", "7") starting at p.
+// On success p is moved past the number.
+bool parseNumber(const char *&p, const char *end, float &value);
+
+typedef bool (*NumberParser)(const char *&p, const char *end, float &value);
+
+// Splits the command part of a line (comment already stripped) in words.
+// The first word is returned in command/code, e.g. 'G' and 1 for "G1 X10".
+// Returns false for empty lines.
+bool parseLine(const char *begin, const char *end, char &command, int &code, Words &words,
+               NumberParser numberParser = parseNumber);
+
+}
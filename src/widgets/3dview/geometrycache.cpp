@@ -0,0 +1,384 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <QAtomicInteger>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QVector>
+#include "geometrycache.h"
+
+namespace
+{
+const char _magic[8] = {'A', 'T', 'L', 'G', 'E', 'O', 'M', '\0'};
+// Bump when the parser output changes
+const quint32 _version = 8;
+const qint64 _defaultMaxSize = 4LL * 1024 * 1024 * 1024;
+// The content hash covers both ends of the file and evenly spread samples in between,
+// reading the whole file would cost as much as parsing it again
+const qint64 _edgeSize = 1024 * 1024;
+const qint64 _sampleSize = 4096;
+const int _sampleCount = 256;
+
+QAtomicInteger<qint64> _maxSize(_defaultMaxSize);
+QAtomicInt _enabled(1);
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 vertexSize;
+    // Last time the entry was written or opened, in ms since epoch
+    qint64 lastUsed;
+    qint64 vertexCount;
+    // Batches, stored right after the header
+    qint64 batchesSize;
+    // GCodeMetadata, stored after the batches
+    qint64 metadataSize;
+    char key[20];
+    quint32 limitsHash;
+    quint32 packingHash;
+    quint32 unused;
+};
+static_assert(sizeof(Header) == 80, "Headers must not depend on the compiler");
+
+// Precedes the vertices, the lines and the index of every batch
+struct BatchHeader {
+    float quantizationOrigin[3];
+    float quantizationSize[3];
+    VertexBatch::Level levels[VertexBatch::levelCount];
+    qint64 verticesSize;
+    qint64 linesSize;
+    qint64 indexSize;
+};
+static_assert(sizeof(BatchHeader) == 96, "Batch headers must not depend on the compiler");
+
+bool readHeader(QFile &file, Header &header)
+{
+    return file.read(reinterpret_cast<char *>(&header), sizeof(Header)) == sizeof(Header)
+           && memcmp(header.magic, _magic, sizeof(_magic)) == 0
+           && header.version == _version
+           && header.vertexSize == sizeof(VertexBatch::Vertex);
+}
+
+QString entrySuffix()
+{
+    return QStringLiteral(".geometry");
+}
+
+// Whether the sizes and the levels of the batch fit its arrays, the vertices are not checked one by one
+bool isValid(const BatchHeader &header, qint64 stride)
+{
+    const qint64 maxSize = std::numeric_limits<int>::max();
+    if (header.verticesSize < 0 || header.verticesSize > maxSize || header.verticesSize % stride != 0
+            || header.linesSize < 0 || header.linesSize > maxSize || header.linesSize % (2 * sizeof(quint32)) != 0
+            || header.indexSize < 0 || header.indexSize > maxSize) {
+        return false;
+    }
+    for (const VertexBatch::Level &level : header.levels) {
+        if (level.firstIndex < 0 || level.extrusionIndexCount < 0 || level.indexCount < level.extrusionIndexCount
+                || (level.firstIndex + qint64(level.indexCount)) * qint64(sizeof(quint32)) > header.linesSize) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+GeometryCache::GeometryCache(const QString &path, const char *data, qint64 size, const GCodeParser::Options &options) :
+    _data(nullptr)
+    , _vertexCount(0)
+    , _batchesSize(0)
+    , _metadataSize(0)
+    , _limitsHash(0)
+    , _packingHash(0)
+    , _writeFailed(false)
+{
+    const QFileInfo info(path);
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(reinterpret_cast<const char *>(&size), sizeof(size));
+    hash.addData(reinterpret_cast<const char *>(&modified), sizeof(modified));
+    hash.addData(reinterpret_cast<const char *>(&options.arcTolerance), sizeof(options.arcTolerance));
+    hash.addData(reinterpret_cast<const char *>(&_version), sizeof(_version));
+    if (size <= 2 * _edgeSize + _sampleCount * _sampleSize) {
+        hash.addData(data, int(size));
+    } else {
+        hash.addData(data, int(_edgeSize));
+        const qint64 stride = (size - 2 * _edgeSize) / _sampleCount;
+        for (int i = 0; i < _sampleCount; ++i) {
+            hash.addData(data + _edgeSize + i * stride, int(_sampleSize));
+        }
+        hash.addData(data + size - _edgeSize, int(_edgeSize));
+    }
+    _key = hash.result();
+    _fileName = directory() + QLatin1Char('/') + QString::fromLatin1(_key.toHex()) + entrySuffix();
+}
+
+GeometryCache::~GeometryCache()
+{
+}
+
+bool GeometryCache::open()
+{
+    if (!isEnabled()) {
+        return false;
+    }
+    _file.setFileName(_fileName);
+    if (!_file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    Header header;
+    if (!readHeader(_file, header) || memcmp(header.key, _key.constData(), sizeof(header.key)) != 0
+            || header.vertexCount < 0 || header.batchesSize < 0 || header.metadataSize < 0
+            || _file.size() != qint64(sizeof(Header)) + header.batchesSize + header.metadataSize) {
+        _file.close();
+        return false;
+    }
+
+    header.lastUsed = QDateTime::currentMSecsSinceEpoch();
+    _file.seek(offsetof(Header, lastUsed));
+    _file.write(reinterpret_cast<const char *>(&header.lastUsed), sizeof(header.lastUsed));
+
+    _data = _file.size() > qint64(sizeof(Header)) ? _file.map(sizeof(Header), _file.size() - qint64(sizeof(Header))) : nullptr;
+    if (!_data) {
+        _file.close();
+        return false;
+    }
+    _vertexCount = header.vertexCount;
+    _batchesSize = header.batchesSize;
+    _metadataSize = header.metadataSize;
+    _limitsHash = header.limitsHash;
+    _packingHash = header.packingHash;
+    return true;
+}
+
+void GeometryCache::close()
+{
+    // Also drops the mapping
+    _file.close();
+    _data = nullptr;
+}
+
+qint64 GeometryCache::vertexCount() const
+{
+    return _vertexCount;
+}
+
+QVector<VertexBatch> GeometryCache::batches() const
+{
+    QVector<VertexBatch> batches;
+    const char *data = reinterpret_cast<const char *>(_data);
+    const char *end = data + _batchesSize;
+    while (data < end) {
+        BatchHeader header;
+        if (end - data < qint64(sizeof(header))) {
+            return QVector<VertexBatch>();
+        }
+        memcpy(&header, data, sizeof(header));
+        data += sizeof(header);
+
+        VertexBatch batch;
+        batch.quantizationOrigin = QVector3D(header.quantizationOrigin[0], header.quantizationOrigin[1], header.quantizationOrigin[2]);
+        batch.quantizationSize = QVector3D(header.quantizationSize[0], header.quantizationSize[1], header.quantizationSize[2]);
+        const qint64 stride = batch.isQuantized() ? sizeof(VertexBatch::QuantizedVertex) : sizeof(VertexBatch::Vertex);
+        if (!isValid(header, stride) || end - data < header.verticesSize + header.linesSize + header.indexSize) {
+            return QVector<VertexBatch>();
+        }
+        std::copy(header.levels, header.levels + VertexBatch::levelCount, batch.levels);
+        batch.vertices = QByteArray(data, int(header.verticesSize));
+        data += header.verticesSize;
+        batch.lines = QByteArray(data, int(header.linesSize));
+        data += header.linesSize;
+        batch.index = ToolpathIndex::fromByteArray(batch, QByteArray::fromRawData(data, int(header.indexSize)));
+        data += header.indexSize;
+        if (batch.index.isEmpty() && batch.levels[0].indexCount > 0) {
+            return QVector<VertexBatch>();
+        }
+        batches.append(batch);
+    }
+    return batches;
+}
+
+GCodeMetadata GeometryCache::metadata() const
+{
+    const char *data = reinterpret_cast<const char *>(_data) + _batchesSize;
+    return GCodeMetadata::fromByteArray(QByteArray::fromRawData(data, int(_metadataSize)));
+}
+
+uint GeometryCache::limitsHash() const
+{
+    return _limitsHash;
+}
+
+uint GeometryCache::packingHash() const
+{
+    return _packingHash;
+}
+
+bool GeometryCache::beginWrite()
+{
+    if (!isEnabled() || !QDir().mkpath(directory())) {
+        return false;
+    }
+    _writer.reset(new QTemporaryFile(directory() + QStringLiteral("/XXXXXX.part")));
+    if (!_writer->open()) {
+        _writer.reset();
+        return false;
+    }
+
+    // Written for real on commit()
+    const Header header = {};
+    _writeFailed = _writer->write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header);
+    _vertexCount = 0;
+    return !_writeFailed;
+}
+
+void GeometryCache::write(const VertexBatch &batch)
+{
+    if (!_writer || _writeFailed) {
+        return;
+    }
+    const QByteArray index = batch.index.toByteArray();
+    BatchHeader header;
+    for (int axis = 0; axis < 3; ++axis) {
+        header.quantizationOrigin[axis] = batch.quantizationOrigin[axis];
+        header.quantizationSize[axis] = batch.quantizationSize[axis];
+    }
+    std::copy(batch.levels, batch.levels + VertexBatch::levelCount, header.levels);
+    header.verticesSize = batch.vertices.size();
+    header.linesSize = batch.lines.size();
+    header.indexSize = index.size();
+    _writeFailed = _writer->write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+                   || _writer->write(batch.vertices) != batch.vertices.size()
+                   || _writer->write(batch.lines) != batch.lines.size()
+                   || _writer->write(index) != index.size();
+    // Every batch but the first repeats the last vertex of the previous one
+    const qint64 count = batch.vertices.size() / (batch.isQuantized() ? sizeof(VertexBatch::QuantizedVertex) : sizeof(VertexBatch::Vertex));
+    _vertexCount += _vertexCount > 0 ? count - 1 : count;
+}
+
+void GeometryCache::commit(const GCodeMetadata &metadata, uint limitsHash, uint packingHash)
+{
+    if (!_writer) {
+        return;
+    }
+
+    const qint64 batchesSize = _writer->pos() - qint64(sizeof(Header));
+    const QByteArray metadataData = metadata.toByteArray();
+    if (!_writeFailed) {
+        _writeFailed = _writer->write(metadataData) != metadataData.size();
+    }
+
+    Header header = {};
+    memcpy(header.magic, _magic, sizeof(_magic));
+    header.version = _version;
+    header.vertexSize = sizeof(VertexBatch::Vertex);
+    header.lastUsed = QDateTime::currentMSecsSinceEpoch();
+    header.vertexCount = _vertexCount;
+    header.batchesSize = batchesSize;
+    header.metadataSize = metadataData.size();
+    memcpy(header.key, _key.constData(), sizeof(header.key));
+    header.limitsHash = limitsHash;
+    header.packingHash = packingHash;
+
+    if (!_writeFailed && _writer->seek(0)
+            && _writer->write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header)
+            && _writer->flush()) {
+        QFile::remove(_fileName);
+        if (_writer->rename(_fileName)) {
+            _writer->setAutoRemove(false);
+        }
+    }
+    // Drops the temporary file when anything failed
+    _writer.reset();
+
+    evict();
+}
+
+QString GeometryCache::directory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/geometry");
+}
+
+qint64 GeometryCache::maxSize()
+{
+    return _maxSize.load();
+}
+
+void GeometryCache::setMaxSize(qint64 size)
+{
+    _maxSize.store(size);
+    evict();
+}
+
+bool GeometryCache::isEnabled()
+{
+    return _enabled.load();
+}
+
+void GeometryCache::setEnabled(bool enabled)
+{
+    _enabled.store(enabled);
+}
+
+void GeometryCache::evict()
+{
+    struct Entry {
+        QString path;
+        qint64 size;
+        qint64 lastUsed;
+    };
+
+    QVector<Entry> entries;
+    qint64 totalSize = 0;
+    const auto files = QDir(directory()).entryInfoList(QStringList(QLatin1Char('*') + entrySuffix()), QDir::Files);
+    for (const QFileInfo &info : files) {
+        QFile file(info.absoluteFilePath());
+        Header header;
+        // Entries of other versions are never used again
+        const qint64 lastUsed = file.open(QIODevice::ReadOnly) && readHeader(file, header) ? header.lastUsed : 0;
+        entries.append({info.absoluteFilePath(), info.size(), lastUsed});
+        totalSize += info.size();
+    }
+    if (totalSize <= maxSize()) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry & a, const Entry & b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    for (const Entry &entry : entries) {
+        if (totalSize <= maxSize()) {
+            break;
+        }
+        if (QFile::remove(entry.path)) {
+            totalSize -= entry.size;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QScopedPointer>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+#include "gcodemetadata.h"
+#include "gcodeparser.h"
+#include "vertexbatch.h"
+
+// Parsed geometry and metadata of G-code files kept on disk between sessions.
+// An entry is found from the file path, size, modification time, the parse options
+// and a hash of the content, the least recently used entries are removed once the
+// cache grows past maxSize().
+// Only the vertex batches are stored, as they were sent with their levels and index.
+// The parsed vertices can be unpacked from them when they are needed again.
+class GeometryCache
+{
+public:
+    // data and size are the whole G-code file
+    GeometryCache(const QString &path, const char *data, qint64 size, const GCodeParser::Options &options);
+    ~GeometryCache();
+
+    // Maps the entry of the file, false when there is none
+    bool open();
+    // Unmaps the entry, a new one can be written afterwards
+    void close();
+    // Of the whole file, without the vertices the batches repeat
+    qint64 vertexCount() const;
+    // Copied out of the mapped entry: LineMesh and the Qt3D buffers keep the arrays as long as the file is drawn,
+    // long after the entry is unmapped, and another load can replace or evict it meanwhile.
+    // Empty when the entry holds none or they do not make sense.
+    QVector<VertexBatch> batches() const;
+    GCodeMetadata metadata() const;
+    // qHash() of the MotionLimits the metadata times were estimated with
+    uint limitsHash() const;
+    // Hash of the settings the batches were packed with, given to commit()
+    uint packingHash() const;
+
+    // Starts a new entry, batches are appended in file order and the entry only becomes visible on commit()
+    bool beginWrite();
+    void write(const VertexBatch &batch);
+    void commit(const GCodeMetadata &metadata, uint limitsHash, uint packingHash);
+
+    static QString directory();
+    static qint64 maxSize();
+    static void setMaxSize(qint64 size);
+    // A disabled cache never finds nor writes entries, the existing ones are kept
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+private:
+    // Removes the least recently used entries until the cache fits in maxSize()
+    static void evict();
+
+    QByteArray _key;
+    QString _fileName;
+    QFile _file;
+    const uchar *_data;
+    qint64 _vertexCount;
+    qint64 _batchesSize;
+    qint64 _metadataSize;
+    uint _limitsHash;
+    uint _packingHash;
+    QScopedPointer<QTemporaryFile> _writer;
+    bool _writeFailed;
+};
@@ -18,9 +18,8 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <QByteArray>
 #include <QGeometryRenderer>
-#include <QVector4D>
-#include <QVector3D>
 #include <QVector2D>
 #include "gridmesh.h"
 #include "linemeshgeometry.h"
@@ -33,17 +32,21 @@ GridMesh::GridMesh(Qt3DCore::QNode *parent) : Qt3DRender::QGeometryRenderer(pare
     setPrimitiveType(Qt3DRender::QGeometryRenderer::Lines);
 
     QVector2D s(20, 20);
-    QList<QVector4D> vertices;
+    QByteArray vertices;
+    auto append = [&vertices](float x, float y) {
+        const float vertex[3] = {x, y, 0};
+        vertices.append(reinterpret_cast<const char *>(vertex), sizeof(vertex));
+    };
     for (uint i = 0; i <= s.x(); i++) {
         for (uint j = 0; j <= s.y(); j++) {
-            vertices.append(QVector4D(i, 0, 0, 0));
-            vertices.append(QVector4D(i, j, 0, 0));
-            vertices.append(QVector4D(0, j, 0, 0));
-            vertices.append(QVector4D(i, j, 0, 0));
+            append(i, 0);
+            append(i, j);
+            append(0, j);
+            append(i, j);
         }
     }
 
-    auto geometry = new LineMeshGeometry(vertices, this);
+    auto geometry = new LineMeshGeometry(vertices, LineMeshGeometry::Positions, this);
     setVertexCount(geometry->vertexCount());
     setGeometry(geometry);
 }
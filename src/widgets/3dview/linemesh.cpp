@@ -18,24 +18,105 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <algorithm>
+#include <limits>
+#include <QByteArray>
+#include <QFile>
 #include <QGeometryRenderer>
-#include <QVector3D>
-#include <QVector4D>
+#include <QMaterial>
+#include <QtConcurrentRun>
+#include <Qt3DCore/QTransform>
+#include <QUrl>
 #include "gcodeto4d.h"
 #include "linemesh.h"
 #include "linemeshgeometry.h"
 
-LineMesh::LineMesh(Qt3DCore::QNode *parent) :
-    Qt3DRender::QGeometryRenderer(parent)
-    , _lineMeshGeo(nullptr)
+namespace
+{
+// 6 vertices of 20 bytes per ribbon, about 60 MB
+const int _maxRibbons = 512 * 1024;
+// mm, thinner layers are drawn as thick as this
+const float _minimumLayerHeight = 0.05f;
+// Vertices are in cm
+const float _mmPerUnit = 10;
+// Draws of a chunk per kind of line for what frustum culling keeps, the lines between more parts are drawn too
+const int _maxCulledParts = 8;
+
+struct Line {
+    quint32 start;
+    quint32 end;
+};
+
+// First line of lines[first, end) ending at or after vertex, lines are in file order
+int lowerBound(const QByteArray &lines, int first, int end, qint64 vertex)
 {
-    setInstanceCount(1);
-    setIndexOffset(0);
-    setFirstInstance(0);
-    setPrimitiveType(Qt3DRender::QGeometryRenderer::LineStrip);
+    const Line *data = reinterpret_cast<const Line *>(lines.constData());
+    return int(std::lower_bound(data + first, data + end, vertex, [](const Line & line, qint64 vertex) {
+        return line.end < vertex;
+    }) - data);
+}
+}
 
-    qRegisterMetaType<QList<QVector4D>>("QList<QVector4D>");
-    connect(&_gcode, &GcodeTo4D::posFinished, this, &LineMesh::posUpdate);
+LineMesh::LineMesh(Qt3DCore::QNode *parent) :
+    Qt3DCore::QEntity(parent)
+    , _chunkCount(0)
+    , _vertexCount(0)
+    , _restarting(false)
+    , _firstLayer(0)
+    , _lastLayer(-1)
+    , _showExtrusions(true)
+    , _showTravels(false)
+    , _detailLevel(0)
+    , _frustumCulling(true)
+    , _showRibbons(false)
+    , _filamentDiameter(1.75f)
+    , _ribbonsOutdated(false)
+    , _ribbonFirstVertex(std::numeric_limits<qint64>::max())
+    , _material(nullptr)
+    , _travelMaterial(nullptr)
+    , _printedMaterial(nullptr)
+    , _printProgress(-1)
+    , _printedVertex(-1)
+    , _playbackTime(-1)
+    , _playbackVertex(-1)
+{
+    qRegisterMetaType<GCodeMetadata>("GCodeMetadata");
+    qRegisterMetaType<VertexBatch>("VertexBatch");
+    _ribbons = createDraw(nullptr);
+    _ribbons.renderer->setPrimitiveType(Qt3DRender::QGeometryRenderer::Triangles);
+    _ribbons.geometry = new LineMeshGeometry(QByteArray(), LineMeshGeometry::Toolpath, _ribbons.entity);
+    _ribbons.renderer->setGeometry(_ribbons.geometry);
+    connect(&_ribbonBuild, &QFutureWatcher<RibbonBuilder::Result>::finished, this, [this] {
+        if (_ribbonsOutdated) {
+            updateRibbons();
+            return;
+        }
+        const RibbonBuilder::Result result = _ribbonBuild.result();
+        _ribbons.geometry->setVertices(result.vertices);
+        _ribbons.renderer->setVertexCount(_ribbons.geometry->vertexCount());
+        _ribbonFirstVertex = result.firstVertex;
+        updateDrawRanges();
+    });
+    connect(&_gcode, &GcodeTo4D::posBatch, this, &LineMesh::posUpdate);
+    connect(&_gcode, &GcodeTo4D::metadataFinished, this, [this](const GCodeMetadata & metadata) {
+        _metadata = metadata;
+        emit metadataChanged();
+        // The progress can only be mapped to a vertex once the positions are known
+        setPrintProgress(_printProgress);
+        setPlaybackTime(_playbackTime);
+        updateDrawRanges();
+        updateRibbons();
+    });
+    connect(&_gcode, &GcodeTo4D::posFinished, this, [this] {
+        // Nothing was read, the previous file must not stay on screen
+        if (_restarting) {
+            _restarting = false;
+            clearChunks(0);
+            _vertexCount = 0;
+            emit vertexCountChanged(_vertexCount);
+        }
+        emit finished();
+    });
 }
 
 LineMesh::~LineMesh()
@@ -44,6 +125,12 @@ LineMesh::~LineMesh()
 
 void LineMesh::readAndRun(const QString &path)
 {
+    // The current file stays visible until the first batch of the new one replaces it
+    _restarting = true;
+    _metadata = GCodeMetadata();
+    emit metadataChanged();
+    clearRibbons();
+    _path = path;
     _gcode.read(path);
 }
 
@@ -52,11 +139,731 @@ void LineMesh::read(const QString &path)
     emit run(path);
 }
 
-void LineMesh::posUpdate(const QList<QVector4D> &pos)
+void LineMesh::posUpdate(const VertexBatch &batch)
+{
+    if (_restarting) {
+        _restarting = false;
+        clearChunks(0);
+        _vertexCount = 0;
+    }
+    const LineMeshGeometry::Layout layout = batch.isQuantized() ? LineMeshGeometry::QuantizedToolpath : LineMeshGeometry::Toolpath;
+    if (_chunkCount == _chunks.size()) {
+        _chunks.append(createChunk(layout));
+    } else if (_chunks.at(_chunkCount).extrusions.geometry->layout() != layout) {
+        destroyChunk(_chunks.at(_chunkCount));
+        _chunks[_chunkCount] = createChunk(layout);
+    }
+    Chunk &chunk = _chunks[_chunkCount++];
+    // Batches after the first one repeat the last vertex of the previous batch
+    chunk.vertexOffset = _vertexCount > 0 ? _vertexCount - 1 : 0;
+    // Qt3D normalizes integer attributes, quantized positions reach the shaders from 0 to 1 across the box
+    chunk.transform->setTranslation(batch.quantizationOrigin);
+    chunk.transform->setScale3D(batch.isQuantized() ? batch.quantizationSize : QVector3D(1, 1, 1));
+    std::copy(batch.levels, batch.levels + VertexBatch::levelCount, chunk.levels);
+    chunk.index = batch.index;
+    chunk.extrusions.geometry->setVertices(batch.vertices);
+    chunk.extrusions.geometry->setLines(batch.lines);
+    _vertexCount = chunk.vertexOffset + chunk.extrusions.geometry->vertexCount();
+    updateDrawRanges();
+    emit vertexCountChanged(_vertexCount);
+}
+
+LineMesh::Draw LineMesh::createDraw(Qt3DRender::QMaterial *material)
+{
+    Draw draw;
+    draw.entity = new Qt3DCore::QEntity(this);
+    draw.renderer = new Qt3DRender::QGeometryRenderer(draw.entity);
+    draw.renderer->setInstanceCount(1);
+    draw.renderer->setIndexOffset(0);
+    draw.renderer->setFirstInstance(0);
+    draw.renderer->setPrimitiveType(Qt3DRender::QGeometryRenderer::Lines);
+    draw.entity->addComponent(draw.renderer);
+    if (material) {
+        draw.entity->addComponent(material);
+    }
+    draw.entity->setEnabled(false);
+    draw.geometry = nullptr;
+    return draw;
+}
+
+LineMesh::Part LineMesh::createPart(const Draw &draw)
+{
+    // The transform of the chunk comes from the parent
+    Part part;
+    part.entity = new Qt3DCore::QEntity(draw.entity);
+    part.renderer = new Qt3DRender::QGeometryRenderer(part.entity);
+    part.renderer->setInstanceCount(1);
+    part.renderer->setIndexOffset(0);
+    part.renderer->setFirstInstance(0);
+    part.renderer->setPrimitiveType(Qt3DRender::QGeometryRenderer::Lines);
+    part.geometry = new LineMeshGeometry(draw.geometry, part.entity);
+    part.renderer->setGeometry(part.geometry);
+    part.entity->addComponent(part.renderer);
+    for (Qt3DCore::QComponent *component : draw.entity->components()) {
+        if (qobject_cast<Qt3DRender::QMaterial *>(component)) {
+            part.entity->addComponent(component);
+        }
+    }
+    part.entity->setEnabled(false);
+    return part;
+}
+
+LineMesh::Chunk LineMesh::createChunk(LineMeshGeometry::Layout layout)
+{
+    Chunk chunk;
+    chunk.extrusions = createDraw(_material);
+    chunk.extrusions.geometry = new LineMeshGeometry(QByteArray(), layout, chunk.extrusions.entity);
+    chunk.extrusions.renderer->setGeometry(chunk.extrusions.geometry);
+    chunk.travels = createDraw(_travelMaterial ? _travelMaterial : _material);
+    chunk.travels.geometry = new LineMeshGeometry(chunk.extrusions.geometry, chunk.travels.entity);
+    chunk.travels.renderer->setGeometry(chunk.travels.geometry);
+    chunk.printed = createDraw(_printedMaterial ? _printedMaterial : _material);
+    chunk.printed.geometry = new LineMeshGeometry(chunk.extrusions.geometry, chunk.printed.entity);
+    chunk.printed.renderer->setGeometry(chunk.printed.geometry);
+    // Destroyed with the extrusions, the last draw of the chunk to go
+    chunk.transform = new Qt3DCore::QTransform(chunk.extrusions.entity);
+    chunk.extrusions.entity->addComponent(chunk.transform);
+    chunk.travels.entity->addComponent(chunk.transform);
+    chunk.printed.entity->addComponent(chunk.transform);
+    chunk.vertexOffset = 0;
+    return chunk;
+}
+
+void LineMesh::destroyChunk(const Chunk &chunk)
+{
+    // The travels and the printed part use the buffers of the extrusions
+    delete chunk.printed.entity;
+    delete chunk.travels.entity;
+    delete chunk.extrusions.entity;
+}
+
+void LineMesh::clearChunks(int first)
+{
+    for (int i = first; i < _chunks.size(); ++i) {
+        _chunks[i].extrusions.entity->setEnabled(false);
+        _chunks[i].travels.entity->setEnabled(false);
+        _chunks[i].printed.entity->setEnabled(false);
+        for (const Draw *draw : {&_chunks.at(i).extrusions, &_chunks.at(i).travels, &_chunks.at(i).printed}) {
+            for (const Part &part : draw->parts) {
+                part.entity->setEnabled(false);
+            }
+        }
+        _chunks[i].extrusions.geometry->clear();
+        _chunks[i].index = ToolpathIndex();
+    }
+    _chunkCount = qMin(_chunkCount, first);
+}
+
+void LineMesh::updateRibbons()
+{
+    if (_ribbonBuild.isRunning()) {
+        _ribbonsOutdated = true;
+        return;
+    }
+    _ribbonsOutdated = false;
+    if (!_showRibbons || _chunkCount == 0 || _metadata.layers.isEmpty()) {
+        clearRibbons();
+        return;
+    }
+
+    // The arrays are shared with the build, the chunks can be replaced meanwhile
+    QVector<RibbonBuilder::Source> sources;
+    for (int i = 0; i < _chunkCount; ++i) {
+        const Chunk &chunk = _chunks.at(i);
+        RibbonBuilder::Source source;
+        source.vertices = chunk.extrusions.geometry->vertices();
+        source.lines = chunk.extrusions.geometry->lines();
+        source.extrusionIndexCount = chunk.levels[0].extrusionIndexCount;
+        source.vertexOffset = chunk.vertexOffset;
+        if (chunk.extrusions.geometry->layout() == LineMeshGeometry::QuantizedToolpath) {
+            source.quantizationOrigin = chunk.transform->translation();
+            source.quantizationSize = chunk.transform->scale3D();
+        }
+        sources.append(source);
+    }
+    RibbonBuilder::Settings settings;
+    layerRange(settings.firstVertex, settings.endVertex);
+    settings.filamentDiameter = _filamentDiameter;
+    float previousZ = 0;
+    for (const GCodeLayer &layer : qAsConst(_metadata.layers)) {
+        settings.layerHeights.append(qMax(layer.z - previousZ, _minimumLayerHeight));
+        previousZ = layer.z;
+    }
+    settings.maxRibbons = _maxRibbons;
+    _ribbonBuild.setFuture(QtConcurrent::run(&RibbonBuilder::build, sources, settings));
+}
+
+void LineMesh::clearRibbons()
+{
+    // A build still running is dropped when it is done
+    _ribbonsOutdated = _ribbonBuild.isRunning();
+    _ribbons.geometry->clear();
+    _ribbons.entity->setEnabled(false);
+    if (_ribbonFirstVertex != std::numeric_limits<qint64>::max()) {
+        _ribbonFirstVertex = std::numeric_limits<qint64>::max();
+        updateDrawRanges();
+    }
+}
+
+void LineMesh::setDrawRanges(Draw &draw, bool show, int firstIndex, int endIndex, const QVector<VertexRange> &ranges)
+{
+    // Lines from the first vertex of a range on, the move into it is not drawn
+    const QByteArray &lines = draw.geometry->lines();
+    int drawn = 0;
+    for (const VertexRange &range : ranges) {
+        const int first = lowerBound(lines, firstIndex / 2, endIndex / 2, range.first + 1) * 2;
+        const int end = lowerBound(lines, first / 2, endIndex / 2, range.end) * 2;
+        if (!show || end <= first) {
+            continue;
+        }
+        if (drawn > draw.parts.size()) {
+            draw.parts.append(createPart(draw));
+        }
+        const Part &part = drawn == 0 ? static_cast<const Part &>(draw) : draw.parts.at(drawn - 1);
+        part.geometry->setIndexRange(first, end - first);
+        part.renderer->setVertexCount(end - first);
+        part.entity->setEnabled(true);
+        ++drawn;
+    }
+    if (drawn == 0) {
+        draw.entity->setEnabled(false);
+    }
+    for (int i = qMax(drawn - 1, 0); i < draw.parts.size(); ++i) {
+        draw.parts.at(i).entity->setEnabled(false);
+    }
+}
+
+QVector<LineMesh::VertexRange> LineMesh::cull(const Chunk &chunk, const ToolpathIndex::Frustum &frustum, int firstIndex, int endIndex,
+                                              const VertexRange &range)
+{
+    const QByteArray &lines = chunk.extrusions.geometry->lines();
+    const int first = lowerBound(lines, firstIndex / 2, endIndex / 2, range.first + 1);
+    const int end = lowerBound(lines, first, endIndex / 2, range.end);
+    QVector<VertexRange> ranges;
+    for (const ToolpathIndex::Span &span : chunk.index.visibleLines(frustum, first, end, _maxCulledParts)) {
+        ranges.append({qMax<qint64>(range.first, chunk.index.lineStart(span.first)),
+                       qMin<qint64>(range.end, chunk.index.lineEnd(span.end - 1) + 1)
+                      });
+    }
+    return ranges;
+}
+
+void LineMesh::layerRange(qint64 &begin, qint64 &end) const
+{
+    const QVector<GCodeLayer> &layers = _metadata.layers;
+    begin = 0;
+    end = _vertexCount;
+    if (_firstLayer > 0 && _firstLayer < layers.size()) {
+        begin = layers.at(_firstLayer).vertexOffset;
+    }
+    if (_lastLayer >= 0 && _lastLayer < layers.size() - 1) {
+        end = layers.at(_lastLayer).vertexOffset + layers.at(_lastLayer).vertexCount;
+    }
+}
+
+QVector3D LineMesh::position(qint64 vertex) const
+{
+    for (int i = _chunkCount - 1; i >= 0; --i) {
+        const Chunk &chunk = _chunks.at(i);
+        if (vertex < chunk.vertexOffset) {
+            continue;
+        }
+        const LineMeshGeometry *geometry = chunk.extrusions.geometry;
+        const int local = int(qMin<qint64>(vertex - chunk.vertexOffset, geometry->vertexCount() - 1));
+        if (geometry->layout() == LineMeshGeometry::QuantizedToolpath) {
+            const auto &packed = reinterpret_cast<const VertexBatch::QuantizedVertex *>(geometry->vertices().constData())[local];
+            return chunk.transform->translation() + QVector3D(packed.x, packed.y, packed.z) / 65535 * chunk.transform->scale3D();
+        }
+        const auto &packed = reinterpret_cast<const VertexBatch::Vertex *>(geometry->vertices().constData())[local];
+        return QVector3D(packed.x, packed.y, packed.z);
+    }
+    return QVector3D();
+}
+
+void LineMesh::updateDrawRanges()
+{
+    // [begin, end) in the whole file
+    qint64 begin;
+    qint64 end;
+    layerRange(begin, end);
+    const bool culling = _frustumCulling && !_viewProjection.isIdentity();
+    const ToolpathIndex::Frustum frustum(_viewProjection);
+    // Moves started before the playback time, the one in progress included
+    if (_playbackVertex >= 0) {
+        end = qMin<qint64>(end, qint64(_playbackVertex) + 2);
+    }
+    const bool ribbons = _showRibbons && _showExtrusions && _playbackVertex < 0 && _ribbons.geometry->vertexCount() > 0;
+    _ribbons.entity->setEnabled(ribbons);
+    // The extrusion lines stop where the ribbons start
+    const qint64 extrusionEnd = ribbons ? qMin(end, _ribbonFirstVertex + 1) : end;
+
+    for (int i = 0; i < _chunkCount; ++i) {
+        Chunk &chunk = _chunks[i];
+        const qint64 first = qMax<qint64>(begin - chunk.vertexOffset, 0);
+        const qint64 last = qMin<qint64>(end - chunk.vertexOffset, chunk.extrusions.geometry->vertexCount());
+        const VertexRange extrusionRange = {first, qMin<qint64>(extrusionEnd - chunk.vertexOffset, last)};
+        const VertexRange travelRange = {first, last};
+        QVector<VertexRange> extrusionRanges = {extrusionRange};
+        QVector<VertexRange> travelRanges = {travelRange};
+        if (culling) {
+            const VertexBatch::Level &full = chunk.levels[0];
+            extrusionRanges = cull(chunk, frustum, 0, full.extrusionIndexCount, extrusionRange);
+            travelRanges = cull(chunk, frustum, full.extrusionIndexCount, full.indexCount, travelRange);
+        }
+        // Split at the printed vertex, lines ending on it are printed
+        const qint64 printed = _printedVertex - chunk.vertexOffset;
+        QVector<VertexRange> printedRanges;
+        QVector<VertexRange> unprintedRanges;
+        for (const VertexRange &range : qAsConst(extrusionRanges)) {
+            if (printed > range.first) {
+                printedRanges.append({range.first, qMin(range.end, printed + 1)});
+            }
+            unprintedRanges.append({qMax(range.first, printed), range.end});
+        }
+        const VertexBatch::Level &level = chunk.levels[_detailLevel];
+        const int travelIndex = level.firstIndex + level.extrusionIndexCount;
+        setDrawRanges(chunk.printed, _showExtrusions, level.firstIndex, travelIndex, printedRanges);
+        setDrawRanges(chunk.extrusions, _showExtrusions, level.firstIndex, travelIndex, unprintedRanges);
+        setDrawRanges(chunk.travels, _showTravels, travelIndex, level.firstIndex + level.indexCount, travelRanges);
+    }
+}
+
+float LineMesh::arcTolerance() const
+{
+    return _gcode.arcTolerance();
+}
+
+void LineMesh::setArcTolerance(float tolerance)
+{
+    if (qFuzzyCompare(tolerance, _gcode.arcTolerance())) {
+        return;
+    }
+    _gcode.setArcTolerance(tolerance);
+    emit arcToleranceChanged(tolerance);
+}
+
+const GCodeMetadata &LineMesh::metadata() const
+{
+    return _metadata;
+}
+
+int LineMesh::layerCount() const
+{
+    return _metadata.layers.size();
+}
+
+double LineMesh::printTime() const
+{
+    return _metadata.printTime;
+}
+
+float LineMesh::maxFeedRate() const
+{
+    return _metadata.maxFeedRate;
+}
+
+void LineMesh::setMotionLimits(const MotionLimits &limits)
+{
+    if (qHash(limits) == qHash(_gcode.motionLimits())) {
+        return;
+    }
+    _gcode.setMotionLimits(limits);
+    // Cheap once the file is cached, only the estimation runs again
+    if (!_path.isEmpty()) {
+        readAndRun(_path);
+    }
+}
+
+bool LineMesh::quantizePositions() const
+{
+    return _gcode.quantize();
+}
+
+void LineMesh::setQuantizePositions(bool quantize)
+{
+    if (quantize == _gcode.quantize()) {
+        return;
+    }
+    _gcode.setQuantization(quantize, _gcode.buildVolume());
+    emit quantizePositionsChanged(quantize);
+    if (!_path.isEmpty()) {
+        readAndRun(_path);
+    }
+}
+
+void LineMesh::setBuildVolume(const QVector3D &volume)
+{
+    if (volume == _gcode.buildVolume()) {
+        return;
+    }
+    _gcode.setQuantization(_gcode.quantize(), volume);
+    if (_gcode.quantize() && !_path.isEmpty()) {
+        readAndRun(_path);
+    }
+}
+
+int LineMesh::firstLayer() const
+{
+    return _firstLayer;
+}
+
+void LineMesh::setFirstLayer(int layer)
+{
+    layer = qMax(layer, 0);
+    if (layer == _firstLayer) {
+        return;
+    }
+    _firstLayer = layer;
+    updateDrawRanges();
+    updateRibbons();
+    emit layerRangeChanged();
+}
+
+int LineMesh::lastLayer() const
+{
+    return _lastLayer;
+}
+
+void LineMesh::setLastLayer(int layer)
+{
+    layer = qMax(layer, -1);
+    if (layer == _lastLayer) {
+        return;
+    }
+    _lastLayer = layer;
+    updateDrawRanges();
+    updateRibbons();
+    emit layerRangeChanged();
+}
+
+bool LineMesh::showExtrusions() const
+{
+    return _showExtrusions;
+}
+
+void LineMesh::setShowExtrusions(bool show)
+{
+    if (show == _showExtrusions) {
+        return;
+    }
+    _showExtrusions = show;
+    updateDrawRanges();
+    emit visibilityChanged();
+}
+
+bool LineMesh::showTravels() const
+{
+    return _showTravels;
+}
+
+void LineMesh::setShowTravels(bool show)
+{
+    if (show == _showTravels) {
+        return;
+    }
+    _showTravels = show;
+    updateDrawRanges();
+    emit visibilityChanged();
+}
+
+bool LineMesh::showRibbons() const
+{
+    return _showRibbons;
+}
+
+void LineMesh::setShowRibbons(bool show)
+{
+    if (show == _showRibbons) {
+        return;
+    }
+    _showRibbons = show;
+    updateRibbons();
+    updateDrawRanges();
+    emit visibilityChanged();
+}
+
+float LineMesh::filamentDiameter() const
+{
+    return _filamentDiameter;
+}
+
+void LineMesh::setFilamentDiameter(float diameter)
+{
+    if (diameter <= 0 || qFuzzyCompare(diameter, _filamentDiameter)) {
+        return;
+    }
+    _filamentDiameter = diameter;
+    updateRibbons();
+    emit filamentDiameterChanged(diameter);
+}
+
+int LineMesh::detailLevel() const
+{
+    return _detailLevel;
+}
+
+void LineMesh::setDetailLevel(int level)
+{
+    level = qBound(0, level, VertexBatch::levelCount - 1);
+    if (level == _detailLevel) {
+        return;
+    }
+    _detailLevel = level;
+    updateDrawRanges();
+    emit detailLevelChanged(level);
+}
+
+int LineMesh::detailLevelCount() const
+{
+    return VertexBatch::levelCount;
+}
+
+int LineMesh::detailLevelFor(float size) const
+{
+    int level = 0;
+    while (level + 1 < VertexBatch::levelCount && VertexBatch::levelTolerance(level + 1) <= size) {
+        ++level;
+    }
+    return level;
+}
+
+QMatrix4x4 LineMesh::viewProjection() const
+{
+    return _viewProjection;
+}
+
+void LineMesh::setViewProjection(const QMatrix4x4 &matrix)
+{
+    if (matrix == _viewProjection) {
+        return;
+    }
+    _viewProjection = matrix;
+    updateDrawRanges();
+    emit viewProjectionChanged(matrix);
+}
+
+bool LineMesh::frustumCulling() const
+{
+    return _frustumCulling;
+}
+
+void LineMesh::setFrustumCulling(bool culling)
+{
+    if (culling == _frustumCulling) {
+        return;
+    }
+    _frustumCulling = culling;
+    updateDrawRanges();
+    emit viewProjectionChanged(_viewProjection);
+}
+
+QVector3D LineMesh::boundsMinimum() const
+{
+    return _metadata.minimum / _mmPerUnit;
+}
+
+QVector3D LineMesh::boundsMaximum() const
+{
+    return _metadata.maximum / _mmPerUnit;
+}
+
+bool LineMesh::pick(const QPointF &point, float radius)
+{
+    bool invertible = false;
+    const QMatrix4x4 inverse = _viewProjection.inverted(&invertible);
+    if (!invertible || _viewProjection.isIdentity()) {
+        return false;
+    }
+    const QVector3D origin = inverse.map(QVector3D(float(point.x()), float(point.y()), -1));
+    const QVector3D direction = (inverse.map(QVector3D(float(point.x()), float(point.y()), 1)) - origin).normalized();
+
+    // Closest hit of every drawn part of every chunk
+    qint64 begin;
+    qint64 end;
+    layerRange(begin, end);
+    float distance = std::numeric_limits<float>::max();
+    qint64 vertex = -1;
+    for (int i = 0; i < _chunkCount; ++i) {
+        const Chunk &chunk = _chunks.at(i);
+        const QByteArray &lines = chunk.extrusions.geometry->lines();
+        const qint64 first = qMax<qint64>(begin - chunk.vertexOffset, 0);
+        const qint64 last = qMin<qint64>(end - chunk.vertexOffset, chunk.extrusions.geometry->vertexCount());
+        const VertexBatch::Level &full = chunk.levels[0];
+        const bool show[2] = {_showExtrusions, _showTravels};
+        const int sections[3] = {0, full.extrusionIndexCount / 2, full.indexCount / 2};
+        for (int section = 0; section < 2; ++section) {
+            if (!show[section]) {
+                continue;
+            }
+            const int firstLine = lowerBound(lines, sections[section], sections[section + 1], first + 1);
+            const int endLine = lowerBound(lines, firstLine, sections[section + 1], last);
+            const int line = chunk.index.pick(origin, direction, radius, firstLine, endLine, distance);
+            if (line >= 0) {
+                vertex = chunk.vertexOffset + chunk.index.lineEnd(line);
+            }
+        }
+    }
+    if (vertex < 0) {
+        return false;
+    }
+
+    // Read again from the closest position of the metadata
+    qint64 line = -1;
+    QFile file(QUrl(_path).path());
+    if (file.open(QIODevice::ReadOnly) && file.size() > 0) {
+        const uchar *data = file.map(0, file.size());
+        if (data) {
+            line = _metadata.sourceLine(vertex, reinterpret_cast<const char *>(data), file.size());
+        }
+    }
+    emit picked(vertex, line);
+    return true;
+}
+
+bool LineMesh::isOnToolpath(const QVector3D &position, float tolerance) const
+{
+    for (int i = 0; i < _chunkCount; ++i) {
+        const Chunk &chunk = _chunks.at(i);
+        if (chunk.index.hasLineWithin(position, tolerance, 0, chunk.levels[0].indexCount / 2)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Qt3DRender::QMaterial *LineMesh::material() const
+{
+    return _material;
+}
+
+void LineMesh::setMaterial(Qt3DRender::QMaterial *material)
+{
+    if (material == _material) {
+        return;
+    }
+    replaceMaterial(_ribbons, _material, material);
+    for (const Chunk &chunk : qAsConst(_chunks)) {
+        replaceMaterial(chunk.extrusions, _material, material);
+        if (!_travelMaterial) {
+            replaceMaterial(chunk.travels, _material, material);
+        }
+        if (!_printedMaterial) {
+            replaceMaterial(chunk.printed, _material, material);
+        }
+    }
+    _material = material;
+    emit materialChanged(material);
+}
+
+Qt3DRender::QMaterial *LineMesh::travelMaterial() const
+{
+    return _travelMaterial;
+}
+
+void LineMesh::setTravelMaterial(Qt3DRender::QMaterial *material)
+{
+    if (material == _travelMaterial) {
+        return;
+    }
+    // Travels use the extrusion material when they have none
+    for (const Chunk &chunk : qAsConst(_chunks)) {
+        replaceMaterial(chunk.travels, _travelMaterial ? _travelMaterial : _material, material ? material : _material);
+    }
+    _travelMaterial = material;
+    emit travelMaterialChanged(material);
+}
+
+float LineMesh::printProgress() const
+{
+    return _printProgress;
+}
+
+void LineMesh::setPrintProgress(float progress)
+{
+    progress = progress < 0 ? -1 : qMin(progress, 100.0f);
+    // Binary search in the positions of the metadata, about one every GCodeParser::positionInterval bytes
+    const qint64 vertex = progress < 0 || _metadata.positions.isEmpty()
+                          ? -1 : _metadata.vertexAt(qint64(double(progress) / 100 * _metadata.byteCount));
+    if (vertex != _printedVertex) {
+        _printedVertex = vertex;
+        updateDrawRanges();
+    }
+    if (progress != _printProgress) {
+        _printProgress = progress;
+        emit printProgressChanged(progress);
+    }
+}
+
+double LineMesh::playbackTime() const
+{
+    return _playbackTime;
+}
+
+void LineMesh::setPlaybackTime(double time)
+{
+    time = time < 0 ? -1 : qMin(time, _metadata.printTime);
+    // Everything is drawn until the times are known
+    const double vertex = time < 0 || _metadata.times.isEmpty()
+                          ? -1 : qBound(0.0, _metadata.vertexAtTime(time), double(qMax<qint64>(_vertexCount - 1, 0)));
+    if (time == _playbackTime && vertex == _playbackVertex) {
+        return;
+    }
+    _playbackTime = time;
+    _playbackVertex = vertex;
+    updateDrawRanges();
+    emit playbackChanged();
+}
+
+QVector3D LineMesh::nozzlePosition() const
+{
+    if (_playbackVertex < 0 || _chunkCount == 0) {
+        return QVector3D();
+    }
+    // Along the move in progress
+    const qint64 vertex = qint64(_playbackVertex);
+    const float fraction = float(_playbackVertex - vertex);
+    const QVector3D from = position(vertex);
+    return fraction > 0 ? from + (position(vertex + 1) - from) * fraction : from;
+}
+
+Qt3DRender::QMaterial *LineMesh::printedMaterial() const
+{
+    return _printedMaterial;
+}
+
+void LineMesh::setPrintedMaterial(Qt3DRender::QMaterial *material)
+{
+    if (material == _printedMaterial) {
+        return;
+    }
+    // The printed part uses the extrusion material when it has none
+    for (const Chunk &chunk : qAsConst(_chunks)) {
+        replaceMaterial(chunk.printed, _printedMaterial ? _printedMaterial : _material, material ? material : _material);
+    }
+    _printedMaterial = material;
+    emit printedMaterialChanged(material);
+}
+
+void LineMesh::replaceMaterial(const Draw &draw, Qt3DRender::QMaterial *previous, Qt3DRender::QMaterial *material)
+{
+    // Materials are shared by every chunk
+    if (previous) {
+        draw.entity->removeComponent(previous);
+    }
+    if (material) {
+        draw.entity->addComponent(material);
+    }
+    for (const Part &part : draw.parts) {
+        if (previous) {
+            part.entity->removeComponent(previous);
+        }
+        if (material) {
+            part.entity->addComponent(material);
+        }
+    }
+}
+
+qint64 LineMesh::vertexCount() const
 {
-    _vertices = pos;
-    _lineMeshGeo = new LineMeshGeometry(_vertices, this);
-    setVertexCount(_lineMeshGeo->vertexCount());
-    setGeometry(_lineMeshGeo);
-    emit finished();
+    return _vertexCount;
 }
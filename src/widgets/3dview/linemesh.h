@@ -20,33 +20,248 @@
 */
 #pragma once
 
-#include <QList>
-#include <QObject>
+#include <QEntity>
+#include <QFutureWatcher>
+#include <QMatrix4x4>
 #include <QNode>
-#include <QGeometryRenderer>
+#include <QObject>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+#include "gcodemetadata.h"
 #include "gcodeto4d.h"
+#include "linemeshgeometry.h"
+#include "printtimeestimator.h"
+#include "ribbonbuilder.h"
+#include "toolpathindex.h"
+#include "vertexbatch.h"
 
-class LineMeshGeometry;
-class QString;
-class QVector4D;
+namespace Qt3DCore
+{
+class QTransform;
+}
+namespace Qt3DRender
+{
+class QGeometryRenderer;
+class QMaterial;
+}
 
-class LineMesh : public Qt3DRender::QGeometryRenderer
+// Toolpath of a G-code file, drawn as indexed lines.
+// Every batch of the loader gets its own buffers and renderers, so files of any size
+// stay below the QByteArray limit. Whatever is shown only changes the drawn index ranges.
+class LineMesh : public Qt3DCore::QEntity
 {
     Q_OBJECT
+    // Maximum distance in mm between G2/G3 arcs and the drawn chords
+    Q_PROPERTY(float arcTolerance READ arcTolerance WRITE setArcTolerance NOTIFY arcToleranceChanged)
+    Q_PROPERTY(int layerCount READ layerCount NOTIFY metadataChanged)
+    // Estimated print time of the loaded file in s, 0 until the load is finished
+    Q_PROPERTY(double printTime READ printTime NOTIFY metadataChanged)
+    // Fastest extruding move of the loaded file in mm/s, the top of the speed colors
+    Q_PROPERTY(float maxFeedRate READ maxFeedRate NOTIFY metadataChanged)
+    // Drawn layers, lastLayer -1 draws up to the last one.
+    // Everything is drawn until the layer table is known.
+    Q_PROPERTY(int firstLayer READ firstLayer WRITE setFirstLayer NOTIFY layerRangeChanged)
+    Q_PROPERTY(int lastLayer READ lastLayer WRITE setLastLayer NOTIFY layerRangeChanged)
+    Q_PROPERTY(bool showExtrusions READ showExtrusions WRITE setShowExtrusions NOTIFY visibilityChanged)
+    Q_PROPERTY(bool showTravels READ showTravels WRITE setShowTravels NOTIFY visibilityChanged)
+    // Extrusions drawn as flat ribbons as wide as the extruded line, once the layer table is known.
+    // They are built on worker threads for the last extrusions of the layer range, and drawn instead of their lines.
+    Q_PROPERTY(bool showRibbons READ showRibbons WRITE setShowRibbons NOTIFY visibilityChanged)
+    // mm, the ribbon widths come from it
+    Q_PROPERTY(float filamentDiameter READ filamentDiameter WRITE setFilamentDiameter NOTIFY filamentDiameterChanged)
+    // Level of detail drawn, 0 is every move, see VertexBatch::levelTolerance().
+    // Levels are more index ranges over the same vertices.
+    Q_PROPERTY(int detailLevel READ detailLevel WRITE setDetailLevel NOTIFY detailLevelChanged)
+    Q_PROPERTY(int detailLevelCount READ detailLevelCount CONSTANT)
+    // Projection times view matrix of the camera, the lines out of its frustum are not drawn.
+    // They are found with the ToolpathIndex of every chunk. Nothing is culled while it is the identity.
+    Q_PROPERTY(QMatrix4x4 viewProjection READ viewProjection WRITE setViewProjection NOTIFY viewProjectionChanged)
+    // Off when other cameras draw the same entities, the matrix is still used for picking
+    Q_PROPERTY(bool frustumCulling READ frustumCulling WRITE setFrustumCulling NOTIFY viewProjectionChanged)
+    // Box of the extruding moves in scene units, null until the load is finished
+    Q_PROPERTY(QVector3D boundsMinimum READ boundsMinimum NOTIFY metadataChanged)
+    Q_PROPERTY(QVector3D boundsMaximum READ boundsMaximum NOTIFY metadataChanged)
+    // Positions as 16-bit integers across the build volume, see FileLoader::setQuantization()
+    Q_PROPERTY(bool quantizePositions READ quantizePositions WRITE setQuantizePositions NOTIFY quantizePositionsChanged)
+    Q_PROPERTY(Qt3DRender::QMaterial *material READ material WRITE setMaterial NOTIFY materialChanged)
+    Q_PROPERTY(Qt3DRender::QMaterial *travelMaterial READ travelMaterial WRITE setTravelMaterial NOTIFY travelMaterialChanged)
+    // Percent of the file sent to the printer, -1 when it is not being printed
+    Q_PROPERTY(float printProgress READ printProgress WRITE setPrintProgress NOTIFY printProgressChanged)
+    Q_PROPERTY(Qt3DRender::QMaterial *printedMaterial READ printedMaterial WRITE setPrintedMaterial NOTIFY printedMaterialChanged)
+    // Estimated time in s the toolpath is drawn up to, found in the times of the metadata, -1 draws all of it.
+    // No ribbons are drawn meanwhile.
+    Q_PROPERTY(double playbackTime READ playbackTime WRITE setPlaybackTime NOTIFY playbackChanged)
+    // Where the nozzle is at playbackTime, in scene units
+    Q_PROPERTY(QVector3D nozzlePosition READ nozzlePosition NOTIFY playbackChanged)
 
 public:
     explicit LineMesh(Qt3DCore::QNode *parent = Q_NULLPTR);
     ~LineMesh();
     void read(const QString &path);
     Q_INVOKABLE void readAndRun(const QString &path);
-    void posUpdate(const QList<QVector4D> &pos);
+    // Adds a batch of the loader to the displayed geometry
+    void posUpdate(const VertexBatch &batch);
+    float arcTolerance() const;
+    void setArcTolerance(float tolerance);
+    // Statistics and layer table of the loaded file, empty until the load is finished
+    const GCodeMetadata &metadata() const;
+    int layerCount() const;
+    double printTime() const;
+    float maxFeedRate() const;
+    // Limits of the printer the estimation is done for, the loaded file is estimated again when they change
+    void setMotionLimits(const MotionLimits &limits);
+    bool quantizePositions() const;
+    void setQuantizePositions(bool quantize);
+    // Printer build volume in mm, the loaded file is read again when it changes
+    void setBuildVolume(const QVector3D &volume);
+    int firstLayer() const;
+    void setFirstLayer(int layer);
+    int lastLayer() const;
+    void setLastLayer(int layer);
+    bool showExtrusions() const;
+    void setShowExtrusions(bool show);
+    bool showTravels() const;
+    void setShowTravels(bool show);
+    bool showRibbons() const;
+    void setShowRibbons(bool show);
+    float filamentDiameter() const;
+    void setFilamentDiameter(float diameter);
+    int detailLevel() const;
+    void setDetailLevel(int level);
+    int detailLevelCount() const;
+    // Coarsest level whose lines stay within size of the moves, size in scene units
+    Q_INVOKABLE int detailLevelFor(float size) const;
+    QMatrix4x4 viewProjection() const;
+    void setViewProjection(const QMatrix4x4 &matrix);
+    bool frustumCulling() const;
+    void setFrustumCulling(bool culling);
+    QVector3D boundsMinimum() const;
+    QVector3D boundsMaximum() const;
+    // Finds the drawn move closest to the camera passing within radius, in scene units, of the ray
+    // through point, in normalized device coordinates. Emits picked() when there is one.
+    Q_INVOKABLE bool pick(const QPointF &point, float radius);
+    // Whether a move of the file, extruding or not, passes within tolerance of position, in vertex units
+    bool isOnToolpath(const QVector3D &position, float tolerance) const;
+    Qt3DRender::QMaterial *material() const;
+    void setMaterial(Qt3DRender::QMaterial *material);
+    Qt3DRender::QMaterial *travelMaterial() const;
+    void setTravelMaterial(Qt3DRender::QMaterial *material);
+    float printProgress() const;
+    // Only moves the boundary between two draw ranges, the geometry stays as it is
+    void setPrintProgress(float progress);
+    double playbackTime() const;
+    // Only a binary search and new draw ranges, the geometry stays as it is
+    void setPlaybackTime(double time);
+    QVector3D nozzlePosition() const;
+    Qt3DRender::QMaterial *printedMaterial() const;
+    void setPrintedMaterial(Qt3DRender::QMaterial *material);
+    // Vertices of the whole file received so far
+    qint64 vertexCount() const;
 
 signals:
+    void arcToleranceChanged(float tolerance);
+    void metadataChanged();
+    void layerRangeChanged();
+    void visibilityChanged();
+    void filamentDiameterChanged(float diameter);
+    void detailLevelChanged(int level);
+    void viewProjectionChanged(const QMatrix4x4 &matrix);
+    // vertex is the end of the move, line its line in the file counted from 0, or -1 when unknown
+    void picked(qint64 vertex, qint64 line);
+    void quantizePositionsChanged(bool quantize);
+    void materialChanged(Qt3DRender::QMaterial *material);
+    void travelMaterialChanged(Qt3DRender::QMaterial *material);
+    void printProgressChanged(float progress);
+    void printedMaterialChanged(Qt3DRender::QMaterial *material);
+    void playbackChanged();
+    void vertexCountChanged(qint64 count);
     void finished();
     void run(const QString &path);
 
 private:
+    // Lines of a range of the index buffer
+    struct Part {
+        Qt3DCore::QEntity *entity;
+        Qt3DRender::QGeometryRenderer *renderer;
+        LineMeshGeometry *geometry;
+    };
+    struct Draw : Part {
+        // The other ranges kept by frustum culling, children of entity with its material, created when needed
+        QVector<Part> parts;
+    };
+    // Vertices [first, end), local to a chunk
+    struct VertexRange {
+        qint64 first;
+        qint64 end;
+    };
+    struct Chunk {
+        // The extrusions own the buffers, the other draws are more index ranges over them
+        Draw extrusions;
+        Draw travels;
+        // Extrusions up to the printed vertex, with printedMaterial
+        Draw printed;
+        // Maps the quantized positions of the chunk back to vertex units, shared by its draws
+        Qt3DCore::QTransform *transform;
+        // Index in the whole file of the first vertex of the buffer
+        qint64 vertexOffset;
+        VertexBatch::Level levels[VertexBatch::levelCount];
+        ToolpathIndex index;
+    };
+
+    Draw createDraw(Qt3DRender::QMaterial *material);
+    static Part createPart(const Draw &draw);
+    Chunk createChunk(LineMeshGeometry::Layout layout);
+    static void destroyChunk(const Chunk &chunk);
+    static void replaceMaterial(const Draw &draw, Qt3DRender::QMaterial *previous, Qt3DRender::QMaterial *material);
+    // Lines of [firstIndex, endIndex) ending in the vertex ranges, one part of the draw per range
+    static void setDrawRanges(Draw &draw, bool show, int firstIndex, int endIndex, const QVector<VertexRange> &ranges);
+    // Parts of the vertex range with full detail lines of [firstIndex, endIndex) in the frustum
+    static QVector<VertexRange> cull(const Chunk &chunk, const ToolpathIndex::Frustum &frustum, int firstIndex, int endIndex,
+                                     const VertexRange &range);
+    // Vertices of the drawn layers, in the whole file
+    void layerRange(qint64 &begin, qint64 &end) const;
+    // Position of a vertex of the whole file in scene units, it must have been received
+    QVector3D position(qint64 vertex) const;
+    // Clears the chunks from index first on, they are kept for the next files
+    void clearChunks(int first);
+    void updateDrawRanges();
+    // Builds the ribbons of the drawn layers again, once the running build is done
+    void updateRibbons();
+    void clearRibbons();
+
     GcodeTo4D _gcode;
-    LineMeshGeometry *_lineMeshGeo;
-    QList<QVector4D> _vertices;
+    // Created once, the chunks in use come first
+    QVector<Chunk> _chunks;
+    int _chunkCount;
+    qint64 _vertexCount;
+    // The previous file is still drawn, the next batch replaces it
+    bool _restarting;
+    int _firstLayer;
+    int _lastLayer;
+    bool _showExtrusions;
+    bool _showTravels;
+    int _detailLevel;
+    QMatrix4x4 _viewProjection;
+    bool _frustumCulling;
+    bool _showRibbons;
+    float _filamentDiameter;
+    Draw _ribbons;
+    QFutureWatcher<RibbonBuilder::Result> _ribbonBuild;
+    // The running build is outdated, its result is dropped
+    bool _ribbonsOutdated;
+    // Extrusions ending after it are drawn as ribbons, in the whole file
+    qint64 _ribbonFirstVertex;
+    Qt3DRender::QMaterial *_material;
+    Qt3DRender::QMaterial *_travelMaterial;
+    Qt3DRender::QMaterial *_printedMaterial;
+    float _printProgress;
+    // Last vertex printed, in the whole file, -1 when nothing is
+    qint64 _printedVertex;
+    double _playbackTime;
+    // Vertex reached at the playback time and the fraction of the move to it done, -1 without playback
+    double _playbackVertex;
+    GCodeMetadata _metadata;
+    QString _path;
 };
@@ -18,43 +18,176 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-#include <QList>
-#include <QVector3D>
-#include <QVector4D>
+#include <cstddef>
+#include <QByteArray>
 #include "linemeshgeometry.h"
+#include "vertexbatch.h"
 
-LineMeshGeometry::LineMeshGeometry(const QList<QVector4D> &vertices, Qt3DCore::QNode *parent) :
+LineMeshGeometry::LineMeshGeometry(const QByteArray &vertices, Layout layout, Qt3DCore::QNode *parent) :
     Qt3DRender::QGeometry(parent)
-    , _positionAttribute(new Qt3DRender::QAttribute(this))
+    , _source(nullptr)
+    , _layout(layout)
+    , _indexAttribute(nullptr)
     , _vertexBuffer(new Qt3DRender::QBuffer(Qt3DRender::QBuffer::VertexBuffer, this))
+    , _indexBuffer(new Qt3DRender::QBuffer(Qt3DRender::QBuffer::IndexBuffer, this))
+    , _vertexCount(0)
 {
-    QByteArray vertexBufferData;
-    vertexBufferData.resize(vertices.size() * 3 * sizeof(float));
-    float *rawVertexArray = reinterpret_cast<float *>(vertexBufferData.data());
-    int idx = 0;
-    for (const auto &v : vertices) {
-        rawVertexArray[idx++] = v.x();
-        rawVertexArray[idx++] = v.y();
-        rawVertexArray[idx++] = v.z();
-        _vertices.append(v.toVector3D());
+    setVertices(vertices);
+    addVertexAttributes();
+}
+
+LineMeshGeometry::LineMeshGeometry(const LineMeshGeometry *source, Qt3DCore::QNode *parent) :
+    Qt3DRender::QGeometry(parent)
+    , _source(source)
+    , _layout(source->_layout)
+    , _indexAttribute(nullptr)
+    , _vertexBuffer(source->_vertexBuffer)
+    , _indexBuffer(source->_indexBuffer)
+    , _vertexCount(0)
+{
+    addVertexAttributes();
+    addIndexAttribute();
+}
+
+LineMeshGeometry::~LineMeshGeometry()
+{
+}
+
+LineMeshGeometry::Layout LineMeshGeometry::layout() const
+{
+    return _layout;
+}
+
+int LineMeshGeometry::vertexCount() const
+{
+    if (_source) {
+        return _source->vertexCount();
     }
+    return _vertexCount;
+}
 
-    _vertexBuffer->setData(vertexBufferData);
+const QByteArray &LineMeshGeometry::vertices() const
+{
+    if (_source) {
+        return _source->vertices();
+    }
+    return _vertexBufferData;
+}
 
-    _positionAttribute->setAttributeType(Qt3DRender::QAttribute::VertexAttribute);
-    _positionAttribute->setBuffer(_vertexBuffer);
-    _positionAttribute->setDataType(Qt3DRender::QAttribute::Float);
-    _positionAttribute->setDataSize(3);
-    _positionAttribute->setName(Qt3DRender::QAttribute::defaultPositionAttributeName());
+int LineMeshGeometry::stride() const
+{
+    switch (_layout) {
+    case Toolpath:
+        return sizeof(VertexBatch::Vertex);
+    case QuantizedToolpath:
+        return sizeof(VertexBatch::QuantizedVertex);
+    case ColoredPositions:
+        return 6 * sizeof(float);
+    default:
+        return 3 * sizeof(float);
+    }
+}
 
-    addAttribute(_positionAttribute);
+void LineMeshGeometry::setVertices(const QByteArray &vertices)
+{
+    _vertexBufferData = vertices;
+    _vertexCount = vertices.size() / stride();
+    _vertexBuffer->setData(_vertexBufferData);
 }
 
-LineMeshGeometry::~LineMeshGeometry()
+void LineMeshGeometry::updateVertices(int first, const QByteArray &vertices)
+{
+    // The buffer updates its array in place only while nothing else shares it
+    _vertexBufferData = QByteArray();
+    _vertexBuffer->updateData(first * stride(), vertices);
+}
+
+void LineMeshGeometry::setLines(const QByteArray &lines)
+{
+    if (!_indexAttribute) {
+        addIndexAttribute();
+    }
+    _indexBufferData = lines;
+    _indexBuffer->setData(_indexBufferData);
+}
+
+const QByteArray &LineMeshGeometry::lines() const
+{
+    if (_source) {
+        return _source->lines();
+    }
+    return _indexBufferData;
+}
+
+void LineMeshGeometry::setIndexRange(int first, int count)
+{
+    if (!_indexAttribute) {
+        addIndexAttribute();
+    }
+    _indexAttribute->setByteOffset(uint(first * sizeof(quint32)));
+    _indexAttribute->setCount(uint(count));
+}
+
+void LineMeshGeometry::clear()
+{
+    setVertices(QByteArray());
+    if (_indexAttribute) {
+        setLines(QByteArray());
+    }
+}
+
+void LineMeshGeometry::addVertexAttributes()
+{
+    if (_layout == Positions) {
+        addVertexAttribute(Qt3DRender::QAttribute::defaultPositionAttributeName(), Qt3DRender::QAttribute::Float, 3, 0);
+        return;
+    }
+    if (_layout == ColoredPositions) {
+        addVertexAttribute(Qt3DRender::QAttribute::defaultPositionAttributeName(), Qt3DRender::QAttribute::Float, 3, 0);
+        addVertexAttribute(Qt3DRender::QAttribute::defaultColorAttributeName(), Qt3DRender::QAttribute::Float, 3, 3 * sizeof(float));
+        return;
+    }
+    // Interleaved, Qt3D always normalizes integer attributes: they reach the shaders as floats from 0 to 1
+    uint attributes;
+    if (_layout == Toolpath) {
+        addVertexAttribute(Qt3DRender::QAttribute::defaultPositionAttributeName(), Qt3DRender::QAttribute::Float, 3,
+                           offsetof(VertexBatch::Vertex, x));
+        attributes = offsetof(VertexBatch::Vertex, attributes);
+    } else {
+        addVertexAttribute(Qt3DRender::QAttribute::defaultPositionAttributeName(), Qt3DRender::QAttribute::UnsignedShort, 3,
+                           offsetof(VertexBatch::QuantizedVertex, x));
+        attributes = offsetof(VertexBatch::QuantizedVertex, attributes);
+    }
+    addVertexAttribute(QStringLiteral("vertexFeedRate"), Qt3DRender::QAttribute::UnsignedShort, 1,
+                       attributes + offsetof(VertexBatch::Attributes, feedRate));
+    addVertexAttribute(QStringLiteral("vertexExtrusion"), Qt3DRender::QAttribute::UnsignedShort, 1,
+                       attributes + offsetof(VertexBatch::Attributes, extrusion));
+    addVertexAttribute(QStringLiteral("vertexLayer"), Qt3DRender::QAttribute::UnsignedShort, 1,
+                       attributes + offsetof(VertexBatch::Attributes, layer));
+    addVertexAttribute(QStringLiteral("vertexFeature"), Qt3DRender::QAttribute::UnsignedByte, 1,
+                       attributes + offsetof(VertexBatch::Attributes, feature));
+}
+
+void LineMeshGeometry::addVertexAttribute(const QString &name, Qt3DRender::QAttribute::VertexBaseType type, uint size, uint offset)
 {
+    auto attribute = new Qt3DRender::QAttribute(this);
+    attribute->setAttributeType(Qt3DRender::QAttribute::VertexAttribute);
+    attribute->setBuffer(_vertexBuffer);
+    attribute->setDataType(type);
+    attribute->setDataSize(size);
+    attribute->setByteOffset(offset);
+    attribute->setByteStride(_layout == Positions ? 0 : uint(stride()));
+    attribute->setName(name);
+    addAttribute(attribute);
 }
 
-int LineMeshGeometry::vertexCount()
+void LineMeshGeometry::addIndexAttribute()
 {
-    return _vertices.size();
+    _indexAttribute = new Qt3DRender::QAttribute(this);
+    _indexAttribute->setAttributeType(Qt3DRender::QAttribute::IndexAttribute);
+    _indexAttribute->setBuffer(_indexBuffer);
+    _indexAttribute->setDataType(Qt3DRender::QAttribute::UnsignedInt);
+    _indexAttribute->setDataSize(1);
+    _indexAttribute->setCount(0);
+    addAttribute(_indexAttribute);
 }
@@ -21,7 +21,9 @@
 #pragma once
 
 #include <QAttribute>
+#include <QByteArray>
 #include <QGeometry>
+#include <QString>
 #include <Qt3DRender/QBuffer>
 
 class LineMeshGeometry : public Qt3DRender::QGeometry
@@ -29,12 +31,50 @@ class LineMeshGeometry : public Qt3DRender::QGeometry
     Q_OBJECT
 
 public:
-    LineMeshGeometry(const QList<QVector4D> &vertices, Qt3DCore::QNode *parent = Q_NULLPTR);
+    enum Layout {
+        // x, y, z floats
+        Positions,
+        // VertexBatch::Vertex
+        Toolpath,
+        // VertexBatch::QuantizedVertex, normalized to [0, 1] and mapped back to vertex units by the entity transform
+        QuantizedToolpath,
+        // x, y, z and r, g, b floats
+        ColoredPositions
+    };
+
+    // Vertices are shared with the vertex buffer as they are
+    explicit LineMeshGeometry(const QByteArray &vertices = QByteArray(), Layout layout = Positions, Qt3DCore::QNode *parent = Q_NULLPTR);
+    // Another range of the lines of source, on the same vertex and index buffers
+    LineMeshGeometry(const LineMeshGeometry *source, Qt3DCore::QNode *parent);
     ~LineMeshGeometry();
-    int vertexCount();
+    Layout layout() const;
+    int vertexCount() const;
+    const QByteArray &vertices() const;
+    // Replaces the vertices, the previous array is freed once it is not drawn anymore
+    void setVertices(const QByteArray &vertices);
+    // Overwrites the vertices from first on, only these bytes are sent again.
+    // vertices() is empty from then on, until setVertices().
+    void updateVertices(int first, const QByteArray &vertices);
+    // Pairs of quint32 vertex indices, the vertices are drawn as separate lines from then on
+    void setLines(const QByteArray &lines);
+    const QByteArray &lines() const;
+    // Draws count indices from first on
+    void setIndexRange(int first, int count);
+    void clear();
 
 private:
-    Qt3DRender::QAttribute *_positionAttribute;
+    int stride() const;
+    void addVertexAttributes();
+    void addVertexAttribute(const QString &name, Qt3DRender::QAttribute::VertexBaseType type, uint size, uint offset);
+    void addIndexAttribute();
+
+    const LineMeshGeometry *_source;
+    Layout _layout;
+    Qt3DRender::QAttribute *_indexAttribute;
     Qt3DRender::QBuffer *_vertexBuffer;
-    QVector<QVector3D> _vertices;
+    Qt3DRender::QBuffer *_indexBuffer;
+    // Shared with the buffers, the only copy of the geometry on this side
+    QByteArray _vertexBufferData;
+    QByteArray _indexBufferData;
+    int _vertexCount;
 };
@@ -0,0 +1,112 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QByteArray>
+#include "linemeshgeometry.h"
+#include "positiontrace.h"
+
+namespace
+{
+const float _traceColor[3] = {0.1f, 0.6f, 1.0f};
+const float _deviationColor[3] = {1.0f, 0.1f, 0.1f};
+}
+
+PositionTrace::PositionTrace(Qt3DCore::QNode *parent) :
+    Qt3DRender::QGeometryRenderer(parent)
+    , _geometry(new LineMeshGeometry(QByteArray(), LineMeshGeometry::ColoredPositions, this))
+    , _capacity(64 * 1024)
+    , _next(0)
+    , _count(0)
+    , _deviationCount(0)
+    , _hasLast(false)
+{
+    setInstanceCount(1);
+    setIndexOffset(0);
+    setFirstInstance(0);
+    setPrimitiveType(Qt3DRender::QGeometryRenderer::Lines);
+    setGeometry(_geometry);
+    clear();
+}
+
+PositionTrace::~PositionTrace()
+{
+}
+
+void PositionTrace::append(const QVector3D &position, bool deviates)
+{
+    if (deviates) {
+        ++_deviationCount;
+        emit deviationCountChanged(_deviationCount);
+    }
+    if (!_hasLast) {
+        _hasLast = true;
+        _last = position;
+        return;
+    }
+
+    const float *color = deviates ? _deviationColor : _traceColor;
+    const float line[12] = {
+        _last.x(), _last.y(), _last.z(), color[0], color[1], color[2],
+        position.x(), position.y(), position.z(), color[0], color[1], color[2]
+    };
+    _geometry->updateVertices(_next * 2, QByteArray(reinterpret_cast<const char *>(line), sizeof(line)));
+    _last = position;
+    _next = (_next + 1) % _capacity;
+    if (_count < _capacity) {
+        ++_count;
+        // Lines can be drawn in any order, the ring needs no reordering
+        setVertexCount(_count * 2);
+    }
+}
+
+void PositionTrace::clear()
+{
+    // Allocated once, later reports only update it
+    _geometry->setVertices(QByteArray(_capacity * 2 * 6 * int(sizeof(float)), 0));
+    _next = 0;
+    _count = 0;
+    _hasLast = false;
+    setVertexCount(0);
+    if (_deviationCount) {
+        _deviationCount = 0;
+        emit deviationCountChanged(_deviationCount);
+    }
+}
+
+int PositionTrace::capacity() const
+{
+    return _capacity;
+}
+
+void PositionTrace::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 1);
+    if (capacity == _capacity) {
+        return;
+    }
+    _capacity = capacity;
+    clear();
+    emit capacityChanged(capacity);
+}
+
+int PositionTrace::deviationCount() const
+{
+    return _deviationCount;
+}
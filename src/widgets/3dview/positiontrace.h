@@ -0,0 +1,64 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QGeometryRenderer>
+#include <QNode>
+#include <QObject>
+#include <QVector3D>
+
+class LineMeshGeometry;
+
+// Positions reported by the printer, drawn as lines between consecutive reports.
+// The vertex buffer has a fixed capacity and is used as a ring: a report only sends its own line,
+// the oldest one is overwritten once it is full. Lines ending off the planned toolpath are red.
+class PositionTrace : public Qt3DRender::QGeometryRenderer
+{
+    Q_OBJECT
+    // Lines kept, setting it clears the trace
+    Q_PROPERTY(int capacity READ capacity WRITE setCapacity NOTIFY capacityChanged)
+    // Reports off the toolpath since the trace was cleared
+    Q_PROPERTY(int deviationCount READ deviationCount NOTIFY deviationCountChanged)
+
+public:
+    explicit PositionTrace(Qt3DCore::QNode *parent = nullptr);
+    ~PositionTrace();
+    // position in vertex units
+    void append(const QVector3D &position, bool deviates);
+    Q_INVOKABLE void clear();
+    int capacity() const;
+    void setCapacity(int capacity);
+    int deviationCount() const;
+
+signals:
+    void capacityChanged(int capacity);
+    void deviationCountChanged(int count);
+
+private:
+    LineMeshGeometry *_geometry;
+    int _capacity;
+    // Next line written, and lines written so far up to the capacity
+    int _next;
+    int _count;
+    int _deviationCount;
+    bool _hasLast;
+    QVector3D _last;
+};
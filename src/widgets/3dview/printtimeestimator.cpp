@@ -0,0 +1,256 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <QSettings>
+#include <QVector4D>
+#include "printtimeestimator.h"
+
+namespace
+{
+// Vertices are in cm
+const double _mmPerUnit = 10;
+// Shorter moves are dropped, like firmwares do with moves of less than a step
+const double _minimumLength = 1e-5;
+// Speed at sharp corners and at the start and end of the print
+const double _minimumSpeed = 0.05;
+
+// Time of a trapezoidal profile going from the entry to the exit speed, given squared
+inline double trapezoidTime(double length, double entrySquared, double exitSquared, double nominal, double acceleration)
+{
+    const double entry = std::sqrt(entrySquared);
+    const double exit = std::sqrt(exitSquared);
+    const double nominalSquared = nominal * nominal;
+    const double cruiseDistance = length - (2 * nominalSquared - entrySquared - exitSquared) / (2 * acceleration);
+    if (cruiseDistance >= 0) {
+        return (2 * nominal - entry - exit) / acceleration + cruiseDistance / nominal;
+    }
+    // Triangle, the nominal speed is never reached
+    const double peak = std::sqrt(qMax(acceleration * length + (entrySquared + exitSquared) / 2, qMax(entrySquared, exitSquared)));
+    return (2 * peak - entry - exit) / acceleration;
+}
+}
+
+MotionLimits MotionLimits::fromProfile(const QString &profile)
+{
+    MotionLimits limits;
+    QSettings settings;
+    settings.beginGroup(QStringLiteral("Profiles"));
+    settings.beginGroup(profile);
+    limits.maxFeedRateXY = settings.value(QStringLiteral("maxFeedRateXY"), limits.maxFeedRateXY).toFloat();
+    limits.maxFeedRateZ = settings.value(QStringLiteral("maxFeedRateZ"), limits.maxFeedRateZ).toFloat();
+    limits.maxFeedRateE = settings.value(QStringLiteral("maxFeedRateE"), limits.maxFeedRateE).toFloat();
+    limits.maxAccelerationXY = settings.value(QStringLiteral("maxAccelerationXY"), limits.maxAccelerationXY).toFloat();
+    limits.maxAccelerationZ = settings.value(QStringLiteral("maxAccelerationZ"), limits.maxAccelerationZ).toFloat();
+    limits.maxAccelerationE = settings.value(QStringLiteral("maxAccelerationE"), limits.maxAccelerationE).toFloat();
+    limits.printAcceleration = settings.value(QStringLiteral("printAcceleration"), limits.printAcceleration).toFloat();
+    limits.travelAcceleration = settings.value(QStringLiteral("travelAcceleration"), limits.travelAcceleration).toFloat();
+    limits.retractAcceleration = settings.value(QStringLiteral("retractAcceleration"), limits.retractAcceleration).toFloat();
+    limits.junctionDeviation = settings.value(QStringLiteral("junctionDeviation"), limits.junctionDeviation).toFloat();
+    limits.jerkXY = settings.value(QStringLiteral("jerkXY"), limits.jerkXY).toFloat();
+    limits.jerkZ = settings.value(QStringLiteral("jerkZ"), limits.jerkZ).toFloat();
+    limits.jerkE = settings.value(QStringLiteral("jerkE"), limits.jerkE).toFloat();
+    limits.lookahead = settings.value(QStringLiteral("lookahead"), limits.lookahead).toInt();
+    settings.endGroup();
+    settings.endGroup();
+    return limits;
+}
+
+const int PrintTimeEstimator::_maxLookahead;
+
+PrintTimeEstimator::PrintTimeEstimator(const MotionLimits &limits) :
+    _limits(limits)
+    , _lookahead(qBound(2, limits.lookahead, _maxLookahead))
+{
+}
+
+void PrintTimeEstimator::add(const QVector4D *vertices, const float *feedRates, int count, GCodeMetadata &metadata)
+{
+    const double maxFeedRate[4] = {_limits.maxFeedRateXY, _limits.maxFeedRateXY, _limits.maxFeedRateZ, _limits.maxFeedRateE};
+    const double maxAcceleration[4] = {_limits.maxAccelerationXY, _limits.maxAccelerationXY, _limits.maxAccelerationZ, _limits.maxAccelerationE};
+
+    for (int i = 0; i < count; ++i, ++_vertex) {
+        const QVector4D &vertex = vertices[i];
+        double delta[4] = {vertex.x() * _mmPerUnit - _last[0], vertex.y() * _mmPerUnit - _last[1], vertex.z() * _mmPerUnit - _last[2], vertex.w() * _mmPerUnit};
+        _last[0] += delta[0];
+        _last[1] += delta[1];
+        _last[2] += delta[2];
+
+        // The length of a move is the XYZ length, or the E length for extruder only moves
+        double length = std::sqrt(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+        double acceleration;
+        if (length >= _minimumLength) {
+            acceleration = delta[3] > 0 ? _limits.printAcceleration : _limits.travelAcceleration;
+        } else if (std::abs(delta[3]) >= _minimumLength) {
+            length = std::abs(delta[3]);
+            delta[0] = delta[1] = delta[2] = 0;
+            acceleration = _limits.retractAcceleration;
+        } else {
+            continue;
+        }
+
+        // Every axis stays within its own limits
+        const double inverseLength = 1 / length;
+        double speed = qMax(double(feedRates[i]), _minimumSpeed);
+        double unit[4];
+        double unitLength = 0;
+        for (int axis = 0; axis < 4; ++axis) {
+            const double ratio = std::abs(delta[axis]) * inverseLength;
+            if (ratio > 0) {
+                speed = qMin(speed, maxFeedRate[axis] / ratio);
+                acceleration = qMin(acceleration, maxAcceleration[axis] / ratio);
+            }
+            unit[axis] = delta[axis];
+            unitLength += delta[axis] * delta[axis];
+        }
+        unitLength = 1 / std::sqrt(unitLength);
+        for (double &component : unit) {
+            component *= unitLength;
+        }
+
+        Block newBlock;
+        newBlock.length = length;
+        newBlock.nominalSpeed = speed;
+        newBlock.acceleration = acceleration;
+        const double entrySpeed = junctionSpeed(unit, speed, acceleration);
+        newBlock.maxEntrySquared = entrySpeed * entrySpeed;
+        newBlock.speedGainSquared = 2 * acceleration * length;
+        newBlock.vertex = _vertex;
+        for (int axis = 0; axis < 4; ++axis) {
+            _previousUnit[axis] = unit[axis];
+        }
+        _previousSpeed = speed;
+
+        if (_count == _lookahead) {
+            executeFirst(metadata);
+        }
+        plan(newBlock);
+    }
+}
+
+void PrintTimeEstimator::finish(GCodeMetadata &metadata)
+{
+    while (_count) {
+        executeFirst(metadata);
+    }
+    for (; _nextPosition < metadata.positions.size(); ++_nextPosition) {
+        metadata.positions[_nextPosition].time = _time;
+    }
+    for (; _nextTimedVertex < _vertex; _nextTimedVertex += GCodeMetadata::timeInterval) {
+        metadata.times.append(float(_time));
+    }
+}
+
+double PrintTimeEstimator::time() const
+{
+    return _time;
+}
+
+PrintTimeEstimator::Block &PrintTimeEstimator::block(int index)
+{
+    return _blocks[(_first + index) & (_maxLookahead - 1)];
+}
+
+double PrintTimeEstimator::junctionSpeed(const double *unit, double nominalSpeed, double acceleration) const
+{
+    if (_previousSpeed == 0) {
+        return _minimumSpeed;
+    }
+    double speed = qMin(nominalSpeed, _previousSpeed);
+
+    if (_limits.junctionDeviation > 0) {
+        // Largest speed going through a circle tangent to both moves, that stays within the deviation
+        const double cosTheta = -(_previousUnit[0] * unit[0] + _previousUnit[1] * unit[1]
+                                  + _previousUnit[2] * unit[2] + _previousUnit[3] * unit[3]);
+        if (cosTheta > 0.999999) {
+            return _minimumSpeed;
+        }
+        if (cosTheta > -0.999999) {
+            const double sinHalfTheta = std::sqrt(0.5 * (1 - cosTheta));
+            speed = qMin(speed, std::sqrt(acceleration * _limits.junctionDeviation * sinHalfTheta / (1 - sinHalfTheta)));
+        }
+        return qMax(speed, _minimumSpeed);
+    }
+
+    // Classic jerk, the instant speed change of every axis is bounded
+    const double jerk[4] = {_limits.jerkXY, _limits.jerkXY, _limits.jerkZ, _limits.jerkE};
+    for (int axis = 0; axis < 4; ++axis) {
+        const double change = std::abs(_previousUnit[axis] - unit[axis]) * speed;
+        if (change > jerk[axis]) {
+            speed *= jerk[axis] / change;
+        }
+    }
+    return qMax(speed, _minimumSpeed);
+}
+
+void PrintTimeEstimator::plan(const Block &newBlock)
+{
+    Block &last = block(_count);
+    last = newBlock;
+    ++_count;
+
+    // Backward pass from the new block, which has to be able to stop.
+    // It stops at the first block whose speed does not change, the ones before it do not change either.
+    // The first block entry is already committed. Speeds are squared all along, no square root needed.
+    int start = 1;
+    double exitSquared = _minimumSpeed * _minimumSpeed;
+    for (int i = _count - 1; i >= 0; --i) {
+        Block &current = block(i);
+        const double squared = qMin(current.maxEntrySquared, exitSquared + current.speedGainSquared);
+        if (i == 0) {
+            if (_count == 1) {
+                current.backwardSquared = current.entrySquared = qMin(squared, _minimumSpeed * _minimumSpeed);
+            }
+            break;
+        }
+        if (i < _count - 1 && squared == current.backwardSquared) {
+            start = i + 1;
+            break;
+        }
+        current.backwardSquared = squared;
+        exitSquared = squared;
+    }
+
+    // Forward pass, entries must be reachable from the previous block
+    for (int i = start; i < _count; ++i) {
+        const Block &previous = block(i - 1);
+        Block &current = block(i);
+        current.entrySquared = qMin(current.backwardSquared, previous.entrySquared + previous.speedGainSquared);
+    }
+}
+
+void PrintTimeEstimator::executeFirst(GCodeMetadata &metadata)
+{
+    const Block &first = block(0);
+    const double exitSquared = _count > 1 ? block(1).entrySquared : _minimumSpeed * _minimumSpeed;
+
+    QVector<GCodePosition> &positions = metadata.positions;
+    for (; _nextPosition < positions.size() && positions.at(_nextPosition).vertex <= first.vertex; ++_nextPosition) {
+        positions[_nextPosition].time = _time;
+    }
+    // Skipped vertices, too short to be moves, get the time of the next move
+    for (; _nextTimedVertex <= first.vertex; _nextTimedVertex += GCodeMetadata::timeInterval) {
+        metadata.times.append(float(_time));
+    }
+    _time += trapezoidTime(first.length, first.entrySquared, exitSquared, first.nominalSpeed, first.acceleration);
+
+    _first = (_first + 1) & (_maxLookahead - 1);
+    --_count;
+}
@@ -0,0 +1,110 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "gcodemetadata.h"
+
+class QVector4D;
+
+// Firmware motion limits of a printer, stored with its profile.
+// Speeds are in mm/s, accelerations in mm/s², XY share the same limits.
+struct MotionLimits {
+    float maxFeedRateXY = 300;
+    float maxFeedRateZ = 5;
+    float maxFeedRateE = 25;
+    float maxAccelerationXY = 3000;
+    float maxAccelerationZ = 100;
+    float maxAccelerationE = 10000;
+    // Default accelerations of moves that extrude, travel or only move the extruder
+    float printAcceleration = 3000;
+    float travelAcceleration = 3000;
+    float retractAcceleration = 3000;
+    // Cornering, junction deviation in mm or classic jerk when it is 0
+    float junctionDeviation = 0.013f;
+    float jerkXY = 10;
+    float jerkZ = 0.3f;
+    float jerkE = 5;
+    // Planner buffer size, in moves
+    int lookahead = 16;
+
+    // Limits of a ProfilesDialog profile, defaults for anything it does not set
+    static MotionLimits fromProfile(const QString &profile);
+};
+
+inline uint qHash(const MotionLimits &limits, uint seed = 0)
+{
+    return qHashBits(&limits, sizeof(limits), seed);
+}
+
+// Simulates the firmware planner over the move stream: trapezoidal velocity profiles,
+// junction speeds from the junction deviation or the jerk, and a lookahead buffer
+// that is replanned on every new move.
+class PrintTimeEstimator
+{
+public:
+    explicit PrintTimeEstimator(const MotionLimits &limits);
+
+    // Moves in file order, vertices as emitted by GCodeParser, feedRates in mm/s.
+    // Fills the time of the positions reached by these moves, and appends to the times of the metadata.
+    void add(const QVector4D *vertices, const float *feedRates, int count, GCodeMetadata &metadata);
+    // Runs the moves still in the planner buffer
+    void finish(GCodeMetadata &metadata);
+    // Seconds, everything executed so far
+    double time() const;
+
+private:
+    struct Block {
+        double length;
+        double nominalSpeed;
+        double acceleration;
+        // Squared speeds, and the squared speed change over the whole block: 2 * acceleration * length
+        double speedGainSquared;
+        double maxEntrySquared;
+        // Entry allowed by the following blocks, and once reachable from the previous ones
+        double backwardSquared;
+        double entrySquared;
+        qint64 vertex;
+    };
+
+    // Power of two, the ring buffer index is masked
+    static const int _maxLookahead = 64;
+
+    Block &block(int index);
+    void plan(const Block &newBlock);
+    void executeFirst(GCodeMetadata &metadata);
+    double junctionSpeed(const double *unit, double nominalSpeed, double acceleration) const;
+
+    MotionLimits _limits;
+    Block _blocks[_maxLookahead];
+    int _first = 0;
+    int _count = 0;
+    int _lookahead;
+    double _last[4] = {0, 0, 0, 0};
+    double _previousUnit[4] = {0, 0, 0, 0};
+    double _previousSpeed = 0;
+    qint64 _vertex = 0;
+    int _nextPosition = 0;
+    qint64 _nextTimedVertex = 0;
+    double _time = 0;
+};
@@ -0,0 +1,148 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cmath>
+#include <QtConcurrentMap>
+#include "ribbonbuilder.h"
+#include "vertexbatch.h"
+
+namespace
+{
+// Ribbons built by one task
+const int _sliceRibbons = 64 * 1024;
+// Two triangles per move
+const int _verticesPerRibbon = 6;
+const float _pi = 3.14159265358979323846f;
+// Vertices are in cm
+const float _mmPerUnit = 10;
+// Layer height when the layer table is missing, and the widest line drawn, mm
+const float _defaultLayerHeight = 0.2f;
+const float _maxWidth = 5;
+
+struct Line {
+    quint32 start;
+    quint32 end;
+};
+
+struct Slice {
+    const RibbonBuilder::Source *source;
+    int firstLine;
+    int endLine;
+    // Index of the first ribbon of the slice in the result
+    int firstRibbon;
+};
+
+// First line of lines[first, end) ending at or after vertex
+int lowerBound(const Line *lines, int first, int end, qint64 vertex)
+{
+    return int(std::lower_bound(lines + first, lines + end, vertex, [](const Line & line, qint64 value) {
+        return line.end < value;
+    }) - lines);
+}
+}
+
+RibbonBuilder::Result RibbonBuilder::build(const QVector<Source> &sources, const Settings &settings)
+{
+    Result result;
+    result.firstVertex = settings.endVertex;
+
+    // The last moves of the range first, the top layers are the ones seen
+    QVector<Slice> slices;
+    int ribbonCount = 0;
+    for (int i = sources.size() - 1; i >= 0 && ribbonCount < settings.maxRibbons; --i) {
+        const Source &source = sources.at(i);
+        const Line *lines = reinterpret_cast<const Line *>(source.lines.constData());
+        const int lineCount = source.extrusionIndexCount / 2;
+        const int first = lowerBound(lines, 0, lineCount, settings.firstVertex - source.vertexOffset + 1);
+        const int end = lowerBound(lines, first, lineCount, settings.endVertex - source.vertexOffset);
+        const int begin = qMax(first, end - (settings.maxRibbons - ribbonCount));
+        if (begin == end) {
+            continue;
+        }
+        for (int line = begin; line < end; line += _sliceRibbons) {
+            Slice slice = {&source, line, qMin(line + _sliceRibbons, end), 0};
+            slices.append(slice);
+        }
+        ribbonCount += end - begin;
+        result.firstVertex = source.vertexOffset + lines[begin].end - 1;
+    }
+    int firstRibbon = 0;
+    for (Slice &slice : slices) {
+        slice.firstRibbon = firstRibbon;
+        firstRibbon += slice.endLine - slice.firstLine;
+    }
+
+    result.vertices.resize(int(qint64(ribbonCount) * _verticesPerRibbon * sizeof(VertexBatch::Vertex)));
+    VertexBatch::Vertex *output = reinterpret_cast<VertexBatch::Vertex *>(result.vertices.data());
+    const float filamentArea = _pi * settings.filamentDiameter * settings.filamentDiameter / 4;
+    const QVector<float> &heights = settings.layerHeights;
+
+    QtConcurrent::blockingMap(slices, [&](const Slice & slice) {
+        const char *vertices = slice.source->vertices.constData();
+        const Line *lines = reinterpret_cast<const Line *>(slice.source->lines.constData());
+        const bool quantized = !slice.source->quantizationSize.isNull();
+        const int stride = quantized ? sizeof(VertexBatch::QuantizedVertex) : sizeof(VertexBatch::Vertex);
+        const QVector3D origin = slice.source->quantizationOrigin;
+        const QVector3D step = slice.source->quantizationSize / 65535;
+        VertexBatch::Vertex *out = output + qint64(slice.firstRibbon) * _verticesPerRibbon;
+        for (int i = slice.firstLine; i < slice.endLine; ++i, out += _verticesPerRibbon) {
+            const char *startVertex = vertices + qint64(lines[i].start) * stride;
+            const char *endVertex = vertices + qint64(lines[i].end) * stride;
+            QVector3D a;
+            QVector3D b;
+            VertexBatch::Attributes attributes;
+            if (quantized) {
+                const auto &start = *reinterpret_cast<const VertexBatch::QuantizedVertex *>(startVertex);
+                const auto &end = *reinterpret_cast<const VertexBatch::QuantizedVertex *>(endVertex);
+                a = origin + QVector3D(start.x, start.y, start.z) * step;
+                b = origin + QVector3D(end.x, end.y, end.z) * step;
+                attributes = end.attributes;
+            } else {
+                const auto &start = *reinterpret_cast<const VertexBatch::Vertex *>(startVertex);
+                const auto &end = *reinterpret_cast<const VertexBatch::Vertex *>(endVertex);
+                a = QVector3D(start.x, start.y, start.z);
+                b = QVector3D(end.x, end.y, end.z);
+                attributes = end.attributes;
+            }
+
+            // Cross section of the move: a rectangle with half circles of the layer height on its sides
+            const float height = heights.isEmpty() ? _defaultLayerHeight : heights.at(qMin<int>(attributes.layer, heights.size() - 1));
+            const float area = attributes.extrusion / 65536.0f * filamentArea;
+            const float width = qBound(0.0f, area / height + height * (1 - _pi / 4), _maxWidth);
+
+            // Half the width across the move in the XY plane, zero wide when it is vertical
+            const float dx = b.x() - a.x();
+            const float dy = b.y() - a.y();
+            const float length = std::sqrt(dx * dx + dy * dy);
+            const float scale = length > 0 ? width / 2 / _mmPerUnit / length : 0;
+            const QVector3D side(-dy * scale, dx * scale, 0);
+
+            const QVector3D corners[_verticesPerRibbon] = {a + side, a - side, b + side, b + side, a - side, b - side};
+            for (int corner = 0; corner < _verticesPerRibbon; ++corner) {
+                out[corner].x = corners[corner].x();
+                out[corner].y = corners[corner].y();
+                out[corner].z = corners[corner].z();
+                out[corner].attributes = attributes;
+            }
+        }
+    });
+    return result;
+}
@@ -0,0 +1,65 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+#include <QVector3D>
+
+// Flat ribbons along the extruding moves, as wide as the line they lay down.
+// The width comes from the filament pushed per mm of move, the filament diameter and the layer height,
+// with the rounded sides of the extruded line taken into account like slicers do.
+class RibbonBuilder
+{
+public:
+    // Full detail vertices and lines of a VertexBatch
+    struct Source {
+        QByteArray vertices;
+        QByteArray lines;
+        int extrusionIndexCount = 0;
+        // Index in the whole file of the first vertex
+        qint64 vertexOffset = 0;
+        // Null size for float positions
+        QVector3D quantizationOrigin;
+        QVector3D quantizationSize;
+    };
+
+    struct Settings {
+        // Vertices of the moves to build, in the whole file
+        qint64 firstVertex = 0;
+        qint64 endVertex = 0;
+        // mm
+        float filamentDiameter = 1.75f;
+        QVector<float> layerHeights;
+        // Only the moves closest to endVertex get a ribbon past this
+        int maxRibbons = 0;
+    };
+
+    struct Result {
+        // Triangles of VertexBatch::Vertex, in vertex units whatever the sources are quantized with
+        QByteArray vertices;
+        // Moves ending from there on have a ribbon
+        qint64 firstVertex = 0;
+    };
+
+    // Runs the sources in parallel slices, call it from a worker thread
+    static Result build(const QVector<Source> &sources, const Settings &settings);
+};
@@ -0,0 +1,361 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cstdint>
+#include <cstring>
+#include "gcodetokenizer.h"
+#include "scankernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ATELIER_X86_KERNELS
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define ATELIER_TARGET(x)
+#else
+#define ATELIER_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+namespace
+{
+
+// Scalar
+const char *scalarFindLineEnd(const char *begin, const char *end)
+{
+    return GCodeTokenizer::findLineEnd(begin, end);
+}
+
+const char *scalarFindLineEndOrComment(const char *begin, const char *end)
+{
+    for (const char *p = begin; p < end; ++p) {
+        if (*p == '\n' || *p == ';') {
+            return p;
+        }
+    }
+    return end;
+}
+
+bool scalarParseNumber(const char *&p, const char *end, float &value)
+{
+    return GCodeTokenizer::parseNumber(p, end, value);
+}
+
+#ifdef ATELIER_X86_KERNELS
+
+const double _pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16
+};
+const uint64_t _pow10i[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL
+};
+
+inline int countTrailingZeros(uint64_t v)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return int(index);
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+// Converts the n <= 8 digits starting at run, at least 8 bytes must be readable at run.
+// SWAR: two digits, then four, then eight are combined inside a single 64 bit word.
+inline uint64_t eightDigits(const char *run, int n)
+{
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t chunk;
+    memcpy(&chunk, run, sizeof(chunk));
+    // Moves the run to the high bytes, the low bytes become leading zeros
+    chunk = (chunk << (8 * (8 - n))) & 0x0F0F0F0F0F0F0F0FULL;
+    chunk = (chunk * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    chunk = ((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+    return chunk;
+}
+
+inline uint64_t sixteenDigits(const char *run, int n)
+{
+    if (n <= 8) {
+        return eightDigits(run, n);
+    }
+    return eightDigits(run, n - 8) * _pow10i[8] + eightDigits(run + n - 8, 8);
+}
+
+// Number layout from the digit and '.' bitmasks of the width bytes at s.
+// Returns false when the window does not hold the whole number, the caller falls back to scalar.
+// width + 8 bytes must be readable at s.
+inline bool windowNumber(const char *s, uint64_t digitMask, uint64_t dotMask, int width, int &consumed, double &result)
+{
+    const uint64_t nonDigit = ~digitMask | (1ULL << width);
+    const int intLen = countTrailingZeros(nonDigit);
+    int fracLen = 0;
+    consumed = intLen;
+    if (intLen < width && (dotMask >> intLen) & 1) {
+        fracLen = countTrailingZeros(nonDigit >> (intLen + 1));
+        consumed = intLen + 1 + fracLen;
+    }
+    if (consumed >= width || intLen + fracLen > 16) {
+        return false;
+    }
+    if (intLen + fracLen == 0) {
+        consumed = -1;
+        return false;
+    }
+
+    uint64_t mantissa = sixteenDigits(s, intLen);
+    if (fracLen) {
+        mantissa = mantissa * uint64_t(_pow10[fracLen]) + sixteenDigits(s + intLen + 1, fracLen);
+    }
+    result = double(mantissa) / _pow10[fracLen];
+    return true;
+}
+
+// SSE2, blocks of 64 bytes as four 16 byte loads, then single 16 byte blocks for the tail
+ATELIER_TARGET("sse2") inline uint64_t sse2LineEndOrCommentMask(const char *p, __m128i newLine, __m128i comment)
+{
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, newLine), _mm_cmpeq_epi8(block, comment))));
+}
+
+ATELIER_TARGET("sse2") inline uint64_t sse2LineEndMask(const char *p, __m128i newLine)
+{
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newLine)));
+}
+
+ATELIER_TARGET("sse2") const char *sse2FindLineEndOrComment(const char *begin, const char *end)
+{
+    const __m128i newLine = _mm_set1_epi8('\n');
+    const __m128i comment = _mm_set1_epi8(';');
+    const char *p = begin;
+    for (; end - p >= 64; p += 64) {
+        const uint64_t mask = sse2LineEndOrCommentMask(p, newLine, comment)
+                              | sse2LineEndOrCommentMask(p + 16, newLine, comment) << 16
+                              | sse2LineEndOrCommentMask(p + 32, newLine, comment) << 32
+                              | sse2LineEndOrCommentMask(p + 48, newLine, comment) << 48;
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    for (; end - p >= 16; p += 16) {
+        const uint64_t mask = sse2LineEndOrCommentMask(p, newLine, comment);
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    return scalarFindLineEndOrComment(p, end);
+}
+
+ATELIER_TARGET("sse2") const char *sse2FindLineEnd(const char *begin, const char *end)
+{
+    const __m128i newLine = _mm_set1_epi8('\n');
+    const char *p = begin;
+    for (; end - p >= 64; p += 64) {
+        const uint64_t mask = sse2LineEndMask(p, newLine)
+                              | sse2LineEndMask(p + 16, newLine) << 16
+                              | sse2LineEndMask(p + 32, newLine) << 32
+                              | sse2LineEndMask(p + 48, newLine) << 48;
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    for (; end - p >= 16; p += 16) {
+        const uint64_t mask = sse2LineEndMask(p, newLine);
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    return scalarFindLineEnd(p, end);
+}
+
+ATELIER_TARGET("sse2") bool sse2ParseNumber(const char *&p, const char *end, float &value)
+{
+    const char *s = p;
+    const bool negative = s < end && *s == '-';
+    if (s < end && (*s == '-' || *s == '+')) {
+        ++s;
+    }
+    if (end - s < 16 + 8) {
+        return scalarParseNumber(p, end, value);
+    }
+
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    const __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+                                          _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+    const uint64_t digitMask = uint32_t(_mm_movemask_epi8(isDigit));
+    const uint64_t dotMask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('.'))));
+
+    int consumed;
+    double result;
+    if (!windowNumber(s, digitMask, dotMask, 16, consumed, result)) {
+        return consumed < 0 ? false : scalarParseNumber(p, end, value);
+    }
+    value = float(negative ? -result : result);
+    p = s + consumed;
+    return true;
+}
+
+// AVX2, blocks of 64 bytes
+ATELIER_TARGET("avx2") const char *avx2FindLineEndOrComment(const char *begin, const char *end)
+{
+    const __m256i newLine = _mm256_set1_epi8('\n');
+    const __m256i comment = _mm256_set1_epi8(';');
+    const char *p = begin;
+    for (; end - p >= 64; p += 64) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        const uint64_t lowMask = uint32_t(_mm256_movemask_epi8(
+                                              _mm256_or_si256(_mm256_cmpeq_epi8(low, newLine), _mm256_cmpeq_epi8(low, comment))));
+        const uint64_t highMask = uint32_t(_mm256_movemask_epi8(
+                                               _mm256_or_si256(_mm256_cmpeq_epi8(high, newLine), _mm256_cmpeq_epi8(high, comment))));
+        const uint64_t mask = lowMask | (highMask << 32);
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    return sse2FindLineEndOrComment(p, end);
+}
+
+ATELIER_TARGET("avx2") const char *avx2FindLineEnd(const char *begin, const char *end)
+{
+    const __m256i newLine = _mm256_set1_epi8('\n');
+    const char *p = begin;
+    for (; end - p >= 64; p += 64) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        const uint64_t lowMask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newLine)));
+        const uint64_t highMask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newLine)));
+        const uint64_t mask = lowMask | (highMask << 32);
+        if (mask) {
+            return p + countTrailingZeros(mask);
+        }
+    }
+    return sse2FindLineEnd(p, end);
+}
+
+ATELIER_TARGET("avx2") bool avx2ParseNumber(const char *&p, const char *end, float &value)
+{
+    const char *s = p;
+    const bool negative = s < end && *s == '-';
+    if (s < end && (*s == '-' || *s == '+')) {
+        ++s;
+    }
+    if (end - s < 32 + 8) {
+        return sse2ParseNumber(p, end, value);
+    }
+
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    const __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)),
+                                             _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+    const uint64_t digitMask = uint32_t(_mm256_movemask_epi8(isDigit));
+    const uint64_t dotMask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('.'))));
+    // The rest is scalar, avoid AVX to SSE transition penalties in the callers
+    _mm256_zeroupper();
+
+    int consumed;
+    double result;
+    if (!windowNumber(s, digitMask, dotMask, 32, consumed, result)) {
+        return consumed < 0 ? false : scalarParseNumber(p, end, value);
+    }
+    value = float(negative ? -result : result);
+    p = s + consumed;
+    return true;
+}
+
+bool cpuHasSse2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return info[3] & (1 << 26);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+const ScanKernels::Kernels _kernels[ScanKernels::LevelCount] = {
+    {ScanKernels::Scalar, "scalar", scalarFindLineEnd, scalarFindLineEndOrComment, scalarParseNumber},
+#ifdef ATELIER_X86_KERNELS
+    {ScanKernels::SSE2, "sse2", sse2FindLineEnd, sse2FindLineEndOrComment, sse2ParseNumber},
+    {ScanKernels::AVX2, "avx2", avx2FindLineEnd, avx2FindLineEndOrComment, avx2ParseNumber},
+#else
+    {ScanKernels::Scalar, "scalar", scalarFindLineEnd, scalarFindLineEndOrComment, scalarParseNumber},
+    {ScanKernels::Scalar, "scalar", scalarFindLineEnd, scalarFindLineEndOrComment, scalarParseNumber},
+#endif
+};
+
+ScanKernels::Level detectLevel()
+{
+#ifdef ATELIER_X86_KERNELS
+    if (cpuHasAvx2()) {
+        return ScanKernels::AVX2;
+    }
+    return cpuHasSse2() ? ScanKernels::SSE2 : ScanKernels::Scalar;
+#else
+    return ScanKernels::Scalar;
+#endif
+}
+}
+
+ScanKernels::Level ScanKernels::bestLevel()
+{
+    static const Level level = detectLevel();
+    return level;
+}
+
+const ScanKernels::Kernels &ScanKernels::kernels()
+{
+    return _kernels[bestLevel()];
+}
+
+const ScanKernels::Kernels &ScanKernels::kernels(Level level)
+{
+    return _kernels[level < bestLevel() ? level : bestLevel()];
+}
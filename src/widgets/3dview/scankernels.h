@@ -0,0 +1,56 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+// Hot loop kernels of the G-code parser.
+// Every kernel has a scalar version and, on x86, SSE2 and AVX2 versions.
+// The best set supported by the running cpu is picked once at runtime.
+namespace ScanKernels
+{
+
+enum Level {
+    Scalar = 0,
+    SSE2,
+    AVX2,
+    LevelCount
+};
+
+struct Kernels {
+    Level level;
+    const char *name;
+    // Pointer to the first '\n' in [begin, end) or end
+    const char *(*findLineEnd)(const char *begin, const char *end);
+    // Pointer to the first '\n' or ';' in [begin, end) or end
+    const char *(*findLineEndOrComment)(const char *begin, const char *end);
+    // Decimal number at p ("-12.345"), moves p past it on success
+    bool (*parseNumber)(const char *&p, const char *end, float &value);
+};
+
+// Best level supported by this cpu
+Level bestLevel();
+
+// Kernels of the best supported level
+const Kernels &kernels();
+
+// Kernels of a given level, falls back to a lower level when not supported
+const Kernels &kernels(Level level);
+
+}
@@ -0,0 +1,171 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <QColor>
+#include <QDropEvent>
+#include <QEntity>
+#include <QFirstPersonCameraController>
+#include <QForwardRenderer>
+#include <QMimeData>
+#include <QMouseEvent>
+#include <QPerVertexColorMaterial>
+#include <QPhongMaterial>
+#include <QPointF>
+#include <QVector3D>
+#include <Qt3DRender/QCamera>
+#include "gridmesh.h"
+#include "linemesh.h"
+#include "positiontrace.h"
+#include "scenewindow.h"
+#include "toolpathmaterial.h"
+
+namespace
+{
+const float _pi = 3.14159265358979f;
+// Time without a camera move before the full detail is drawn again, ms
+const int _stillInterval = 300;
+}
+
+SceneWindow::SceneWindow(QScreen *screen) :
+    Qt3DExtras::Qt3DWindow(screen)
+    , _root(new Qt3DCore::QEntity)
+{
+    defaultFrameGraph()->setClearColor(QColor(Qt::white));
+
+    Qt3DRender::QCamera *view = camera();
+    view->lens()->setPerspectiveProjection(45, 16.0f / 9, 0.01f, 1000);
+    view->setPosition(QVector3D(10, -10, 35));
+    view->setUpVector(QVector3D(0, 0.85f, 0.75f));
+    view->setViewCenter(QVector3D(10, 10, 0));
+    auto controller = new Qt3DExtras::QFirstPersonCameraController(_root);
+    controller->setCamera(view);
+
+    auto grid = new Qt3DCore::QEntity(_root);
+    auto gridMaterial = new Qt3DExtras::QPhongMaterial(grid);
+    gridMaterial->setAmbient(QColor(QStringLiteral("darkblue")));
+    grid->addComponent(new GridMesh(grid));
+    grid->addComponent(gridMaterial);
+
+    auto lineMaterial = new ToolpathMaterial(_root);
+    auto printedMaterial = new ToolpathMaterial(_root);
+    printedMaterial->setBrightness(0.35f);
+    auto travelMaterial = new Qt3DExtras::QPhongMaterial(_root);
+    travelMaterial->setAmbient(QColor(QStringLiteral("gray")));
+
+    _lineMesh = new LineMesh(_root);
+    _lineMesh->setMaterial(lineMaterial);
+    _lineMesh->setTravelMaterial(travelMaterial);
+    _lineMesh->setPrintedMaterial(printedMaterial);
+    connect(_lineMesh, &LineMesh::metadataChanged, this, [this, lineMaterial, printedMaterial] {
+        for (ToolpathMaterial *material : {lineMaterial, printedMaterial}) {
+            material->setMaxFeedRate(_lineMesh->maxFeedRate());
+            material->setLayerCount(_lineMesh->layerCount());
+        }
+    });
+
+    auto updateViewProjection = [this] {
+        _lineMesh->setViewProjection(camera()->projectionMatrix() * camera()->viewMatrix());
+    };
+    updateViewProjection();
+    connect(view, &Qt3DRender::QCamera::projectionMatrixChanged, this, updateViewProjection);
+    connect(view, &Qt3DRender::QCamera::viewMatrixChanged, this, updateViewProjection);
+    connect(view, &Qt3DRender::QCamera::positionChanged, this, &SceneWindow::cameraMoved);
+    connect(view, &Qt3DRender::QCamera::viewCenterChanged, this, &SceneWindow::cameraMoved);
+
+    _stillTimer.setSingleShot(true);
+    _stillTimer.setInterval(_stillInterval);
+    connect(&_stillTimer, &QTimer::timeout, this, [this] {
+        _lineMesh->setDetailLevel(0);
+    });
+
+    // Where the printer reported being, next to the planned toolpath
+    auto trace = new Qt3DCore::QEntity(_root);
+    _positionTrace = new PositionTrace(trace);
+    trace->addComponent(_positionTrace);
+    trace->addComponent(new Qt3DExtras::QPerVertexColorMaterial(trace));
+
+    setRootEntity(_root);
+}
+
+SceneWindow::~SceneWindow()
+{
+}
+
+LineMesh *SceneWindow::lineMesh() const
+{
+    return _lineMesh;
+}
+
+PositionTrace *SceneWindow::positionTrace() const
+{
+    return _positionTrace;
+}
+
+bool SceneWindow::event(QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::DragEnter:
+    case QEvent::DragMove:
+    case QEvent::Drop: {
+        auto drop = static_cast<QDropEvent *>(event);
+        if (!drop->mimeData()->hasUrls()) {
+            break;
+        }
+        drop->acceptProposedAction();
+        if (event->type() == QEvent::Drop) {
+            emit droppedUrls(drop->mimeData()->urls());
+        }
+        return true;
+    }
+    default:
+        break;
+    }
+    return Qt3DExtras::Qt3DWindow::event(event);
+}
+
+void SceneWindow::mousePressEvent(QMouseEvent *event)
+{
+    _pressPosition = event->pos();
+    Qt3DExtras::Qt3DWindow::mousePressEvent(event);
+}
+
+void SceneWindow::mouseReleaseEvent(QMouseEvent *event)
+{
+    // Clicks only, not the end of a camera drag
+    if ((event->pos() - _pressPosition).manhattanLength() < 4) {
+        const QPointF point(2.0 * event->x() / qMax(width(), 1) - 1, 1 - 2.0 * event->y() / qMax(height(), 1));
+        _lineMesh->pick(point, 4 * pixelSize());
+    }
+    Qt3DExtras::Qt3DWindow::mouseReleaseEvent(event);
+}
+
+float SceneWindow::pixelSize() const
+{
+    const Qt3DRender::QCamera *view = camera();
+    const float distance = (view->position() - view->viewCenter()).length();
+    return 2 * distance * std::tan(view->fieldOfView() * _pi / 360) / qMax(height(), 1);
+}
+
+void SceneWindow::cameraMoved()
+{
+    _lineMesh->setDetailLevel(_lineMesh->detailLevelFor(pixelSize()));
+    _stillTimer.start();
+}
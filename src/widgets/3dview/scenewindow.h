@@ -0,0 +1,71 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QPoint>
+#include <QTimer>
+#include <QUrl>
+#include <Qt3DWindow>
+
+class LineMesh;
+class PositionTrace;
+
+namespace Qt3DCore
+{
+class QEntity;
+}
+
+// The scene of AnimatedEntity built in C++ and drawn straight into a native window,
+// without the QML engine and the Qt Quick scene graph in between.
+// It has no controls, the file is drawn with the defaults of LineMesh: no ribbons,
+// layer range, color scheme, playback or multiple views.
+class SceneWindow : public Qt3DExtras::Qt3DWindow
+{
+    Q_OBJECT
+
+public:
+    explicit SceneWindow(QScreen *screen = nullptr);
+    ~SceneWindow() override;
+    LineMesh *lineMesh() const;
+    PositionTrace *positionTrace() const;
+
+signals:
+    void droppedUrls(const QList<QUrl> &urls);
+
+protected:
+    bool event(QEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    // Size of a pixel at the view center, in scene units
+    float pixelSize() const;
+    void cameraMoved();
+
+    Qt3DCore::QEntity *_root;
+    LineMesh *_lineMesh;
+    PositionTrace *_positionTrace;
+    // Coarser levels of detail are drawn while the camera moves, full detail once it stops
+    QTimer _stillTimer;
+    QPoint _pressPosition;
+};
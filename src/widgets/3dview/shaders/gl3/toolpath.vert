@@ -0,0 +1,61 @@
+#version 150 core
+
+in vec3 vertexPosition;
+// Attributes as stored in VertexBatch::Attributes, normalized by Qt3D
+in float vertexFeedRate;
+// Filament per mm of the move, 1/65536 mm
+in float vertexExtrusion;
+in float vertexLayer;
+in float vertexFeature;
+
+out vec3 color;
+
+uniform mat4 mvp;
+// 0: feature, 1: speed, 2: layer, 3: flow
+uniform int colorScheme;
+uniform float maxFeedRate;
+uniform float layerCount;
+// Scales every color, the printed part of a file is darker
+uniform float brightness;
+
+vec3 featureColor(float feature)
+{
+    if (feature < 0.5) return vec3(0.0, 0.39, 0.0);   // Unknown
+    if (feature < 1.5) return vec3(0.9, 0.3, 0.1);    // Outer wall
+    if (feature < 2.5) return vec3(0.95, 0.75, 0.1);  // Inner wall
+    if (feature < 3.5) return vec3(0.8, 0.2, 0.6);    // Skin
+    if (feature < 4.5) return vec3(0.75, 0.35, 0.1);  // Infill
+    if (feature < 5.5) return vec3(0.2, 0.7, 0.7);    // Support
+    if (feature < 6.5) return vec3(0.2, 0.5, 0.9);    // Skirt, brim
+    return vec3(0.5, 0.5, 0.5);                        // Other
+}
+
+vec3 heat(float ratio)
+{
+    ratio = clamp(ratio, 0.0, 1.0);
+    return ratio < 0.5 ? mix(vec3(0.1, 0.2, 0.9), vec3(0.1, 0.8, 0.2), ratio * 2.0)
+                       : mix(vec3(0.1, 0.8, 0.2), vec3(0.9, 0.1, 0.1), ratio * 2.0 - 1.0);
+}
+
+void main()
+{
+    // Qt3D normalizes the integer attributes, they come from 0 to 1
+    float feedRate = vertexFeedRate * 65535.0;
+    float extrusion = vertexExtrusion * 65535.0;
+    float layer = floor(vertexLayer * 65535.0 + 0.5);
+    float feature = floor(vertexFeature * 255.0 + 0.5);
+
+    if (colorScheme == 1) {
+        color = heat(feedRate * 0.1 / max(maxFeedRate, 1.0));
+    } else if (colorScheme == 2) {
+        // Every other layer darker, so neighbours stay apart
+        color = heat(layer / max(layerCount - 1.0, 1.0)) * (mod(layer, 2.0) < 0.5 ? 1.0 : 0.8);
+    } else if (colorScheme == 3) {
+        // Red from 0.07 mm of filament per mm, about twice a 0.4 mm wide line of a 0.2 mm layer with 1.75 mm filament
+        color = heat(extrusion / 65536.0 / 0.07);
+    } else {
+        color = featureColor(feature);
+    }
+    color *= brightness;
+    gl_Position = mvp * vec4(vertexPosition, 1.0);
+}
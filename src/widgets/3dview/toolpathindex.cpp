@@ -0,0 +1,392 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <QMatrix4x4>
+#include <QtConcurrentMap>
+#include "toolpathindex.h"
+#include "vertexbatch.h"
+
+namespace
+{
+// Leaves built by one task
+const int _sliceLeaves = 4096;
+
+inline QVector3D minimum(const QVector3D &a, const QVector3D &b)
+{
+    return QVector3D(qMin(a.x(), b.x()), qMin(a.y(), b.y()), qMin(a.z(), b.z()));
+}
+
+inline QVector3D maximum(const QVector3D &a, const QVector3D &b)
+{
+    return QVector3D(qMax(a.x(), b.x()), qMax(a.y(), b.y()), qMax(a.z(), b.z()));
+}
+
+bool intersects(const QVector3D &low, const QVector3D &high, const ToolpathIndex::Frustum &frustum)
+{
+    // Outside as soon as the corner furthest along a plane normal is behind it
+    for (const QVector4D &plane : frustum.planes) {
+        const float x = plane.x() >= 0 ? high.x() : low.x();
+        const float y = plane.y() >= 0 ? high.y() : low.y();
+        const float z = plane.z() >= 0 ? high.z() : low.z();
+        if (plane.x() * x + plane.y() * y + plane.z() * z + plane.w() < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Distance along the ray to the box grown by radius, false when the ray misses it
+bool rayHitsBox(const QVector3D &origin, const QVector3D &direction, const QVector3D &low, const QVector3D &high,
+                float radius, float &entry)
+{
+    float enter = 0;
+    float leave = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; ++axis) {
+        const float from = low[axis] - radius;
+        const float to = high[axis] + radius;
+        if (direction[axis] == 0) {
+            if (origin[axis] < from || origin[axis] > to) {
+                return false;
+            }
+            continue;
+        }
+        const float inverse = 1 / direction[axis];
+        float t0 = (from - origin[axis]) * inverse;
+        float t1 = (to - origin[axis]) * inverse;
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        enter = qMax(enter, t0);
+        leave = qMin(leave, t1);
+        if (enter > leave) {
+            return false;
+        }
+    }
+    entry = enter;
+    return true;
+}
+
+// Squared distance between the ray and the segment [a, b], t is the distance along the ray of the closest point
+float raySegmentDistanceSquared(const QVector3D &origin, const QVector3D &direction, const QVector3D &a, const QVector3D &b, float &t)
+{
+    const QVector3D u = b - a;
+    const QVector3D w = origin - a;
+    const float uu = QVector3D::dotProduct(u, u);
+    const float ud = QVector3D::dotProduct(u, direction);
+    const float uw = QVector3D::dotProduct(u, w);
+    const float dw = QVector3D::dotProduct(direction, w);
+    const float denominator = uu - ud * ud;
+    float s = denominator > 1e-12f ? qBound(0.0f, (uw - dw * ud) / denominator, 1.0f) : 0;
+    t = qMax(s * ud - dw, 0.0f);
+    if (uu > 0) {
+        s = qBound(0.0f, (uw + t * ud) / uu, 1.0f);
+    }
+    return (w + direction * t - u * s).lengthSquared();
+}
+
+// Squared distance between the point and the segment [a, b]
+float pointSegmentDistanceSquared(const QVector3D &point, const QVector3D &a, const QVector3D &b)
+{
+    const QVector3D u = b - a;
+    const float uu = QVector3D::dotProduct(u, u);
+    const float s = uu > 0 ? qBound(0.0f, QVector3D::dotProduct(point - a, u) / uu, 1.0f) : 0;
+    return (a + u * s - point).lengthSquared();
+}
+
+// Squared distance between the point and the box, 0 inside it
+float pointBoxDistanceSquared(const QVector3D &point, const QVector3D &low, const QVector3D &high)
+{
+    const QVector3D outside = maximum(maximum(low - point, point - high), QVector3D());
+    return outside.lengthSquared();
+}
+}
+
+ToolpathIndex::Frustum::Frustum(const QMatrix4x4 &viewProjection)
+{
+    const QVector4D w = viewProjection.row(3);
+    for (int axis = 0; axis < 3; ++axis) {
+        planes[axis * 2] = w + viewProjection.row(axis);
+        planes[axis * 2 + 1] = w - viewProjection.row(axis);
+    }
+}
+
+void ToolpathIndex::build(const VertexBatch &batch)
+{
+    setBatch(batch);
+    if (_lineCount == 0) {
+        return;
+    }
+
+    QVector<Box> leaves((_lineCount + _leafSize - 1) / _leafSize);
+    QVector<int> slices;
+    for (int leaf = 0; leaf < leaves.size(); leaf += _sliceLeaves) {
+        slices.append(leaf);
+    }
+    QtConcurrent::blockingMap(slices, [this, &leaves](int firstLeaf) {
+        const int endLeaf = qMin(firstLeaf + _sliceLeaves, leaves.size());
+        for (int leaf = firstLeaf; leaf < endLeaf; ++leaf) {
+            const int endLine = qMin((leaf + 1) * _leafSize, _lineCount);
+            Box box = lineBox(leaf * _leafSize);
+            for (int line = leaf * _leafSize + 1; line < endLine; ++line) {
+                const Box other = lineBox(line);
+                box.minimum = minimum(box.minimum, other.minimum);
+                box.maximum = maximum(box.maximum, other.maximum);
+            }
+            leaves[leaf] = box;
+        }
+    });
+    _levels.append(leaves);
+
+    while (_levels.last().size() > 1) {
+        const QVector<Box> &below = _levels.last();
+        QVector<Box> level((below.size() + 1) / 2);
+        for (int node = 0; node < level.size(); ++node) {
+            Box box = below.at(node * 2);
+            if (node * 2 + 1 < below.size()) {
+                const Box &other = below.at(node * 2 + 1);
+                box.minimum = minimum(box.minimum, other.minimum);
+                box.maximum = maximum(box.maximum, other.maximum);
+            }
+            level[node] = box;
+        }
+        _levels.append(level);
+    }
+}
+
+QByteArray ToolpathIndex::toByteArray() const
+{
+    // The size of every level follows from the line count
+    QByteArray data;
+    for (const QVector<Box> &level : _levels) {
+        data.append(reinterpret_cast<const char *>(level.constData()), int(level.size() * sizeof(Box)));
+    }
+    return data;
+}
+
+ToolpathIndex ToolpathIndex::fromByteArray(const VertexBatch &batch, const QByteArray &data)
+{
+    ToolpathIndex index;
+    index.setBatch(batch);
+    const char *in = data.constData();
+    qint64 remaining = data.size();
+    int size = (index._lineCount + _leafSize - 1) / _leafSize;
+    while (size > 0) {
+        if (remaining < qint64(size) * qint64(sizeof(Box))) {
+            return ToolpathIndex();
+        }
+        QVector<Box> level(size);
+        memcpy(level.data(), in, size * sizeof(Box));
+        in += size * sizeof(Box);
+        remaining -= size * sizeof(Box);
+        index._levels.append(level);
+        size = size > 1 ? (size + 1) / 2 : 0;
+    }
+    return remaining == 0 ? index : ToolpathIndex();
+}
+
+bool ToolpathIndex::isEmpty() const
+{
+    return _levels.isEmpty();
+}
+
+quint32 ToolpathIndex::lineStart(int line) const
+{
+    return reinterpret_cast<const quint32 *>(_lines.constData())[line * 2];
+}
+
+quint32 ToolpathIndex::lineEnd(int line) const
+{
+    return reinterpret_cast<const quint32 *>(_lines.constData())[line * 2 + 1];
+}
+
+QVector<ToolpathIndex::Span> ToolpathIndex::visibleLines(const Frustum &frustum, int first, int end, int maxSpans) const
+{
+    first = qMax(first, 0);
+    end = qMin(end, _lineCount);
+    QVector<Span> spans;
+    if (isEmpty() || first >= end) {
+        return spans;
+    }
+    visibleLines(frustum, _levels.size() - 1, 0, first, end, spans);
+    if (spans.size() <= maxSpans) {
+        return spans;
+    }
+
+    // The joined gaps are the narrowest ones, the widest of them is found without sorting them all
+    QVector<int> gaps;
+    for (int i = 1; i < spans.size(); ++i) {
+        gaps.append(spans.at(i).first - spans.at(i - 1).end);
+    }
+    const int joinCount = spans.size() - qMax(maxSpans, 1);
+    std::nth_element(gaps.begin(), gaps.begin() + joinCount - 1, gaps.end());
+    const int widest = gaps.at(joinCount - 1);
+    int widestLeft = joinCount - int(std::count_if(gaps.constBegin(), gaps.constEnd(), [widest](int gap) {
+        return gap < widest;
+    }));
+    QVector<Span> joined;
+    joined.append(spans.first());
+    for (int i = 1; i < spans.size(); ++i) {
+        const int gap = spans.at(i).first - joined.last().end;
+        if (gap < widest || (gap == widest && widestLeft-- > 0)) {
+            joined.last().end = spans.at(i).end;
+        } else {
+            joined.append(spans.at(i));
+        }
+    }
+    return joined;
+}
+
+int ToolpathIndex::pick(const QVector3D &origin, const QVector3D &direction, float radius, int first, int end, float &distance) const
+{
+    first = qMax(first, 0);
+    end = qMin(end, _lineCount);
+    int line = -1;
+    if (!isEmpty() && first < end) {
+        pick(origin, direction, radius, _levels.size() - 1, 0, first, end, distance, line);
+    }
+    return line;
+}
+
+bool ToolpathIndex::hasLineWithin(const QVector3D &point, float radius, int first, int end) const
+{
+    first = qMax(first, 0);
+    end = qMin(end, _lineCount);
+    return !isEmpty() && first < end && hasLineWithin(point, radius * radius, _levels.size() - 1, 0, first, end);
+}
+
+void ToolpathIndex::setBatch(const VertexBatch &batch)
+{
+    _vertices = batch.vertices;
+    _lines = batch.lines;
+    _lineCount = batch.levels[0].indexCount / 2;
+    _quantized = batch.isQuantized();
+    _stride = _quantized ? sizeof(VertexBatch::QuantizedVertex) : sizeof(VertexBatch::Vertex);
+    _origin = batch.quantizationOrigin;
+    _step = batch.quantizationStep();
+    _levels.clear();
+}
+
+QVector3D ToolpathIndex::position(quint32 vertex) const
+{
+    const char *data = _vertices.constData() + qint64(vertex) * _stride;
+    if (!_quantized) {
+        const VertexBatch::Vertex &packed = *reinterpret_cast<const VertexBatch::Vertex *>(data);
+        return QVector3D(packed.x, packed.y, packed.z);
+    }
+    const VertexBatch::QuantizedVertex &packed = *reinterpret_cast<const VertexBatch::QuantizedVertex *>(data);
+    return _origin + QVector3D(packed.x, packed.y, packed.z) * _step;
+}
+
+ToolpathIndex::Box ToolpathIndex::lineBox(int line) const
+{
+    const QVector3D a = position(lineStart(line));
+    const QVector3D b = position(lineEnd(line));
+    Box box;
+    box.minimum = minimum(a, b);
+    box.maximum = maximum(a, b);
+    return box;
+}
+
+int ToolpathIndex::nodeBegin(int level, int node, int first) const
+{
+    return qMax((node << level) * _leafSize, first);
+}
+
+int ToolpathIndex::nodeEnd(int level, int node, int end) const
+{
+    return qMin(((node + 1) << level) * _leafSize, end);
+}
+
+void ToolpathIndex::visibleLines(const Frustum &frustum, int level, int node, int first, int end, QVector<Span> &spans) const
+{
+    const int begin = nodeBegin(level, node, first);
+    const int nodeLast = nodeEnd(level, node, end);
+    const Box &box = _levels.at(level).at(node);
+    if (begin >= nodeLast || !intersects(box.minimum, box.maximum, frustum)) {
+        return;
+    }
+    if (level == 0) {
+        // Leaves are visited in line order, neighbours make one span
+        if (!spans.isEmpty() && spans.last().end == begin) {
+            spans.last().end = nodeLast;
+        } else {
+            spans.append({begin, nodeLast});
+        }
+        return;
+    }
+    const int below = node * 2;
+    visibleLines(frustum, level - 1, below, first, end, spans);
+    if (below + 1 < _levels.at(level - 1).size()) {
+        visibleLines(frustum, level - 1, below + 1, first, end, spans);
+    }
+}
+
+void ToolpathIndex::pick(const QVector3D &origin, const QVector3D &direction, float radius, int level, int node, int first, int end,
+                         float &distance, int &line) const
+{
+    const int begin = nodeBegin(level, node, first);
+    const int nodeLast = nodeEnd(level, node, end);
+    const Box &box = _levels.at(level).at(node);
+    float entry;
+    if (begin >= nodeLast || !rayHitsBox(origin, direction, box.minimum, box.maximum, radius, entry) || entry > distance) {
+        return;
+    }
+    if (level == 0) {
+        const float radiusSquared = radius * radius;
+        for (int i = begin; i < nodeLast; ++i) {
+            float t;
+            if (raySegmentDistanceSquared(origin, direction, position(lineStart(i)), position(lineEnd(i)), t) <= radiusSquared
+                    && t < distance) {
+                distance = t;
+                line = i;
+            }
+        }
+        return;
+    }
+    const int below = node * 2;
+    pick(origin, direction, radius, level - 1, below, first, end, distance, line);
+    if (below + 1 < _levels.at(level - 1).size()) {
+        pick(origin, direction, radius, level - 1, below + 1, first, end, distance, line);
+    }
+}
+
+bool ToolpathIndex::hasLineWithin(const QVector3D &point, float radiusSquared, int level, int node, int first, int end) const
+{
+    const int begin = nodeBegin(level, node, first);
+    const int nodeLast = nodeEnd(level, node, end);
+    const Box &box = _levels.at(level).at(node);
+    if (begin >= nodeLast || pointBoxDistanceSquared(point, box.minimum, box.maximum) > radiusSquared) {
+        return false;
+    }
+    if (level == 0) {
+        for (int i = begin; i < nodeLast; ++i) {
+            if (pointSegmentDistanceSquared(point, position(lineStart(i)), position(lineEnd(i))) <= radiusSquared) {
+                return true;
+            }
+        }
+        return false;
+    }
+    const int below = node * 2;
+    return hasLineWithin(point, radiusSquared, level - 1, below, first, end)
+           || (below + 1 < _levels.at(level - 1).size() && hasLineWithin(point, radiusSquared, level - 1, below + 1, first, end));
+}
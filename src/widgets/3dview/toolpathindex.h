@@ -0,0 +1,99 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+#include <QVector3D>
+#include <QVector4D>
+
+class QMatrix4x4;
+struct VertexBatch;
+
+// Bounding box hierarchy over the full detail lines of a VertexBatch, in vertex units.
+// Lines that follow each other in the file are close to each other, so they are not sorted:
+// a leaf holds consecutive lines and a node the two consecutive nodes below it.
+// A node is then a range of lines, what is found maps straight back to index ranges of the draws.
+class ToolpathIndex
+{
+public:
+    // Inside when dot(plane, (x, y, z, 1)) >= 0 for all of them
+    struct Frustum {
+        explicit Frustum(const QMatrix4x4 &viewProjection);
+        QVector4D planes[6];
+    };
+
+    // Lines [first, end)
+    struct Span {
+        int first;
+        int end;
+    };
+
+    // Boxes of the lines of batch, the leaves are built in parallel
+    void build(const VertexBatch &batch);
+    // The boxes of every level, to be stored next to the batch
+    QByteArray toByteArray() const;
+    // Index of batch from the boxes of toByteArray(), empty when they do not fit its lines
+    static ToolpathIndex fromByteArray(const VertexBatch &batch, const QByteArray &data);
+    bool isEmpty() const;
+    // Lines are quint32 pairs of batch.lines, line i is the indices 2 * i and 2 * i + 1
+    quint32 lineStart(int line) const;
+    quint32 lineEnd(int line) const;
+    // Lines of [first, end) whose leaf is in the frustum, in file order. Past maxSpans spans, the ones
+    // with the fewest lines between them are joined, and those lines are kept too.
+    QVector<Span> visibleLines(const Frustum &frustum, int first, int end, int maxSpans) const;
+    // Line of [first, end) passing within radius of the ray, and closer along it than distance, -1 when none.
+    // direction is normalized, distance is updated on a hit so several indexes can be searched in turn.
+    int pick(const QVector3D &origin, const QVector3D &direction, float radius, int first, int end, float &distance) const;
+    // Whether a line of [first, end) passes within radius of point
+    bool hasLineWithin(const QVector3D &point, float radius, int first, int end) const;
+
+private:
+    struct Box {
+        QVector3D minimum;
+        QVector3D maximum;
+    };
+
+    static const int _leafSize = 16;
+
+    // Shares the arrays of batch, without any box
+    void setBatch(const VertexBatch &batch);
+    QVector3D position(quint32 vertex) const;
+    Box lineBox(int line) const;
+    // Lines of the node at level, clipped to [first, end)
+    int nodeBegin(int level, int node, int first) const;
+    int nodeEnd(int level, int node, int end) const;
+    void visibleLines(const Frustum &frustum, int level, int node, int first, int end, QVector<Span> &spans) const;
+    void pick(const QVector3D &origin, const QVector3D &direction, float radius, int level, int node, int first, int end,
+              float &distance, int &line) const;
+    bool hasLineWithin(const QVector3D &point, float radiusSquared, int level, int node, int first, int end) const;
+
+    // Shared with the geometry, nothing is copied
+    QByteArray _vertices;
+    QByteArray _lines;
+    int _lineCount = 0;
+    int _stride = 0;
+    bool _quantized = false;
+    QVector3D _origin;
+    QVector3D _step;
+    // Leaves first, the last level is the root
+    QVector<QVector<Box> > _levels;
+};
@@ -0,0 +1,158 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QByteArray>
+#include <QEffect>
+#include <QFilterKey>
+#include <QGraphicsApiFilter>
+#include <QParameter>
+#include <QRenderPass>
+#include <QShaderProgram>
+#include <QStringList>
+#include <QTechnique>
+#include <QUrl>
+#include <QVariant>
+#include "toolpathmaterial.h"
+
+namespace
+{
+// Shader variants, the es2 ones also run on OpenGL 2
+struct ShaderApi {
+    Qt3DRender::QGraphicsApiFilter::Api api;
+    Qt3DRender::QGraphicsApiFilter::OpenGLProfile profile;
+    int majorVersion;
+    int minorVersion;
+    const char *directory;
+};
+
+const ShaderApi _shaderApis[] = {
+    {Qt3DRender::QGraphicsApiFilter::OpenGL, Qt3DRender::QGraphicsApiFilter::CoreProfile, 3, 2, "gl3"},
+    {Qt3DRender::QGraphicsApiFilter::OpenGL, Qt3DRender::QGraphicsApiFilter::NoProfile, 2, 0, "es2"},
+    {Qt3DRender::QGraphicsApiFilter::OpenGLES, Qt3DRender::QGraphicsApiFilter::NoProfile, 2, 0, "es2"}
+};
+
+// In the order of the colorScheme uniform values
+const QStringList _colorSchemes = {QStringLiteral("feature"), QStringLiteral("speed"), QStringLiteral("layer"), QStringLiteral("flow")};
+
+QByteArray shaderSource(const char *directory, const char *stage)
+{
+    return Qt3DRender::QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/shaders/%1/toolpath.%2").arg(QLatin1String(directory), QLatin1String(stage))));
+}
+}
+
+ToolpathMaterial::ToolpathMaterial(Qt3DCore::QNode *parent) :
+    Qt3DRender::QMaterial(parent)
+    , _colorSchemeName(_colorSchemes.first())
+    , _colorScheme(new Qt3DRender::QParameter(QStringLiteral("colorScheme"), QVariant(0), this))
+    , _maxFeedRate(new Qt3DRender::QParameter(QStringLiteral("maxFeedRate"), QVariant(100.0f), this))
+    // Uploaded with the type of the variant, the shaders declare it as a float
+    , _layerCount(new Qt3DRender::QParameter(QStringLiteral("layerCount"), QVariant(1.0f), this))
+    , _brightness(new Qt3DRender::QParameter(QStringLiteral("brightness"), QVariant(1.0f), this))
+{
+    addParameter(_colorScheme);
+    addParameter(_maxFeedRate);
+    addParameter(_layerCount);
+    addParameter(_brightness);
+
+    auto effect = new Qt3DRender::QEffect(this);
+    for (const ShaderApi &shaderApi : _shaderApis) {
+        auto technique = new Qt3DRender::QTechnique(effect);
+        technique->graphicsApiFilter()->setApi(shaderApi.api);
+        technique->graphicsApiFilter()->setProfile(shaderApi.profile);
+        technique->graphicsApiFilter()->setMajorVersion(shaderApi.majorVersion);
+        technique->graphicsApiFilter()->setMinorVersion(shaderApi.minorVersion);
+
+        auto filterKey = new Qt3DRender::QFilterKey(technique);
+        filterKey->setName(QStringLiteral("renderingStyle"));
+        filterKey->setValue(QStringLiteral("forward"));
+        technique->addFilterKey(filterKey);
+
+        auto renderPass = new Qt3DRender::QRenderPass(technique);
+        auto shaderProgram = new Qt3DRender::QShaderProgram(renderPass);
+        shaderProgram->setVertexShaderCode(shaderSource(shaderApi.directory, "vert"));
+        shaderProgram->setFragmentShaderCode(shaderSource(shaderApi.directory, "frag"));
+        renderPass->setShaderProgram(shaderProgram);
+        technique->addRenderPass(renderPass);
+        effect->addTechnique(technique);
+    }
+    setEffect(effect);
+}
+
+ToolpathMaterial::~ToolpathMaterial()
+{
+}
+
+QString ToolpathMaterial::colorScheme() const
+{
+    return _colorSchemeName;
+}
+
+void ToolpathMaterial::setColorScheme(const QString &scheme)
+{
+    if (scheme == _colorSchemeName) {
+        return;
+    }
+    _colorSchemeName = scheme;
+    // Unknown schemes color by feature
+    _colorScheme->setValue(qMax(_colorSchemes.indexOf(scheme), 0));
+    emit colorSchemeChanged(scheme);
+}
+
+float ToolpathMaterial::maxFeedRate() const
+{
+    return _maxFeedRate->value().toFloat();
+}
+
+void ToolpathMaterial::setMaxFeedRate(float rate)
+{
+    if (rate == maxFeedRate()) {
+        return;
+    }
+    _maxFeedRate->setValue(rate);
+    emit maxFeedRateChanged(rate);
+}
+
+int ToolpathMaterial::layerCount() const
+{
+    return int(_layerCount->value().toFloat());
+}
+
+void ToolpathMaterial::setLayerCount(int count)
+{
+    if (count == layerCount()) {
+        return;
+    }
+    _layerCount->setValue(float(count));
+    emit layerCountChanged(count);
+}
+
+float ToolpathMaterial::brightness() const
+{
+    return _brightness->value().toFloat();
+}
+
+void ToolpathMaterial::setBrightness(float brightness)
+{
+    if (brightness == this->brightness()) {
+        return;
+    }
+    _brightness->setValue(brightness);
+    emit brightnessChanged(brightness);
+}
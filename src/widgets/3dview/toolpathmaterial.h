@@ -0,0 +1,68 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QMaterial>
+#include <QNode>
+#include <QObject>
+#include <QString>
+
+namespace Qt3DRender
+{
+class QParameter;
+}
+
+// Colors the toolpath from its vertex attributes, see LineMeshGeometry::Toolpath.
+// Changing the scheme only changes a uniform. Used from QML and by SceneWindow.
+class ToolpathMaterial : public Qt3DRender::QMaterial
+{
+    Q_OBJECT
+    // "feature", "speed", "layer" or "flow", the filament pushed per mm of move
+    Q_PROPERTY(QString colorScheme READ colorScheme WRITE setColorScheme NOTIFY colorSchemeChanged)
+    Q_PROPERTY(float maxFeedRate READ maxFeedRate WRITE setMaxFeedRate NOTIFY maxFeedRateChanged)
+    Q_PROPERTY(int layerCount READ layerCount WRITE setLayerCount NOTIFY layerCountChanged)
+    Q_PROPERTY(float brightness READ brightness WRITE setBrightness NOTIFY brightnessChanged)
+
+public:
+    explicit ToolpathMaterial(Qt3DCore::QNode *parent = nullptr);
+    ~ToolpathMaterial();
+    QString colorScheme() const;
+    void setColorScheme(const QString &scheme);
+    float maxFeedRate() const;
+    void setMaxFeedRate(float rate);
+    int layerCount() const;
+    void setLayerCount(int count);
+    float brightness() const;
+    void setBrightness(float brightness);
+
+signals:
+    void colorSchemeChanged(const QString &scheme);
+    void maxFeedRateChanged(float rate);
+    void layerCountChanged(int count);
+    void brightnessChanged(float brightness);
+
+private:
+    QString _colorSchemeName;
+    Qt3DRender::QParameter *_colorScheme;
+    Qt3DRender::QParameter *_maxFeedRate;
+    Qt3DRender::QParameter *_layerCount;
+    Qt3DRender::QParameter *_brightness;
+};
@@ -0,0 +1,102 @@
+/* Atelier KDE Printer Host for 3D Printing
+    Copyright (C) <2026>
+    Author: Atelier developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 3 of
+    the License or any later version accepted by the membership of
+    KDE e.V. (or its successor approved by the membership of KDE
+    e.V.), which shall act as a proxy defined in Section 14 of
+    version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QVector3D>
+#include "toolpathindex.h"
+
+// Part of the geometry of a file, laid out for the vertex and index buffers.
+// Every batch but the first starts with the last vertex of the previous one.
+struct VertexBatch {
+    // About the move that ends on the vertex
+    struct Attributes {
+        // 0.1 mm/s
+        quint16 feedRate;
+        // Filament per mm of the move, 1/65536 mm, 0 for travels and retractions
+        quint16 extrusion;
+        // Layer of GCodeMetadata::layers
+        quint16 layer;
+        // GCodeParser::Feature
+        quint8 feature;
+        quint8 unused;
+    };
+
+    struct Vertex {
+        float x;
+        float y;
+        float z;
+        Attributes attributes;
+    };
+
+    // Position from 0 to 65535 across the quantization box
+    struct QuantizedVertex {
+        quint16 x;
+        quint16 y;
+        quint16 z;
+        quint16 unused;
+        Attributes attributes;
+    };
+
+    // Range of lines of a level of detail, in indices
+    struct Level {
+        int firstIndex = 0;
+        int extrusionIndexCount = 0;
+        int indexCount = 0;
+    };
+
+    // Full detail, then lines of more and more moves merged together
+    static const int levelCount = 4;
+
+    // Interleaved Vertex, or QuantizedVertex when quantizationSize is not null
+    QByteArray vertices;
+    // quint32 pairs of vertices, the extruding ones first and then the travels, for every level.
+    // At full detail there is a line per move, moves that do not move the head, like retractions, have none.
+    QByteArray lines;
+    Level levels[levelCount];
+    // Box of the quantized positions of this batch in vertex units
+    QVector3D quantizationOrigin;
+    QVector3D quantizationSize;
+    // Boxes of the full detail lines, for culling and picking
+    ToolpathIndex index;
+
+    bool isQuantized() const
+    {
+        return !quantizationSize.isNull();
+    }
+    // Largest distance in vertex units between the vertices skipped at a level and the lines drawn instead
+    static float levelTolerance(int level)
+    {
+        // 0.05, 0.2 and 0.8 mm
+        return level > 0 ? 0.005f * (1 << (2 * (level - 1))) : 0;
+    }
+    // Vertex units between two quantized positions
+    QVector3D quantizationStep() const
+    {
+        return quantizationSize / 65535;
+    }
+};
+
+static_assert(sizeof(VertexBatch::Vertex) == 20, "Vertex attributes must stay packed");
+static_assert(sizeof(VertexBatch::QuantizedVertex) == 16, "Vertex attributes must stay packed");
+
+Q_DECLARE_METATYPE(VertexBatch)
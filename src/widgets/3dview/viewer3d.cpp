@@ -19,6 +19,7 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <KLocalizedContext>
 #include <QDebug>
 #include <QDirIterator>
 #include <QHBoxLayout>
@@ -28,34 +29,143 @@
 #include <QQmlEngine>
 #include <QQuickItem>
 #include <QQuickView>
+#include <QSettings>
+#include <QVector3D>
 #include "gridmesh.h"
 #include "viewer3d.h"
 #include "linemesh.h"
+#include "positiontrace.h"
+#include "printtimeestimator.h"
+#include "scenewindow.h"
+#include "toolpathmaterial.h"
+
+namespace
+{
+// Vertices are in cm
+const float _mmPerUnit = 10;
+// Reports further than this from every move of the file are deviations, mm
+const float _deviationTolerance = 0.5f;
+
+Viewer3D::Backend savedBackend()
+{
+    QSettings settings;
+    settings.beginGroup(QStringLiteral("Viewer3D"));
+    const QString backend = settings.value(QStringLiteral("backend")).toString();
+    settings.endGroup();
+    return backend == QStringLiteral("window") ? Viewer3D::WindowBackend : Viewer3D::QuickBackend;
+}
+}
 
 Viewer3D::Viewer3D(QWidget *parent) :
+    Viewer3D(savedBackend(), parent)
+{
+}
+
+Viewer3D::Viewer3D(Backend backend, QWidget *parent) :
     QWidget(parent)
-    , _lineMesh(new LineMesh)
+    , _backend(backend)
+    , _container(nullptr)
+    , _view(nullptr)
+    , _sceneWindow(nullptr)
 {
     Q_INIT_RESOURCE(viewer3d);
 
     qmlRegisterType<GridMesh>("GridMesh", 1, 0, "GridMesh");
     qmlRegisterType<LineMesh>("LineMesh", 1, 0, "LineMesh");
+    qmlRegisterType<PositionTrace>("PositionTrace", 1, 0, "PositionTrace");
+    qmlRegisterType<ToolpathMaterial>("ToolpathMaterial", 1, 0, "ToolpathMaterial");
+    // i18n() for the QML panels, translated with the rest of Atelier
+    _engine.rootContext()->setContextObject(new KLocalizedContext(&_engine));
 
-    _view = new QQuickView(&_engine, nullptr);
-    _view->setResizeMode(QQuickView::SizeRootObjectToView);
-    _view->setSource(QUrl(QStringLiteral("qrc:/viewer3d.qml")));
     QHBoxLayout *mainLayout = new QHBoxLayout;
-    mainLayout->addWidget(QWidget::createWindowContainer(_view));
-    QObject *item = _view->rootObject();
-    //Connect the drop pass from the QML part.
-    connect(item, SIGNAL(droppedUrls(QVariant)), this, SLOT(dropCatch(QVariant)));
     this->setLayout(mainLayout);
+    createView();
+
+    //Estimate for the first printer until one is connected
+    QSettings settings;
+    settings.beginGroup(QStringLiteral("Profiles"));
+    const QStringList profiles = settings.childGroups();
+    settings.endGroup();
+    if (!profiles.isEmpty()) {
+        setProfile(profiles.first());
+    }
 }
 
 Viewer3D::~Viewer3D()
 {
 }
 
+Viewer3D::Backend Viewer3D::backend() const
+{
+    return _backend;
+}
+
+void Viewer3D::setBackend(Backend backend)
+{
+    if (backend == _backend) {
+        return;
+    }
+    _backend = backend;
+    createView();
+    updateMotionLimits();
+
+    QSettings settings;
+    settings.beginGroup(QStringLiteral("Viewer3D"));
+    settings.setValue(QStringLiteral("backend"), backend == WindowBackend ? QStringLiteral("window") : QStringLiteral("quick"));
+    settings.endGroup();
+
+    if (!_file.isEmpty()) {
+        drawModel(_file);
+    }
+}
+
+void Viewer3D::createView()
+{
+    // The container owns the window, the previous view goes with it
+    delete _container;
+    _view = nullptr;
+    _sceneWindow = nullptr;
+
+    if (_backend == WindowBackend) {
+        _sceneWindow = new SceneWindow;
+        connect(_sceneWindow, &SceneWindow::droppedUrls, this, &Viewer3D::droppedUrls);
+        _container = QWidget::createWindowContainer(_sceneWindow, this);
+    } else {
+        _view = new QQuickView(&_engine, nullptr);
+        _view->setResizeMode(QQuickView::SizeRootObjectToView);
+        _view->setSource(QUrl(QStringLiteral("qrc:/viewer3d.qml")));
+        //Connect the drop pass from the QML part.
+        connect(_view->rootObject(), SIGNAL(droppedUrls(QVariant)), this, SLOT(dropCatch(QVariant)));
+        _container = QWidget::createWindowContainer(_view, this);
+    }
+    layout()->addWidget(_container);
+
+    LineMesh *mesh = lineMesh();
+    if (mesh) {
+        connect(mesh, &LineMesh::picked, this, [this](qint64, qint64 line) {
+            if (line >= 0) {
+                emit lineClicked(QUrl(_file), int(line));
+            }
+        });
+    }
+}
+
+LineMesh *Viewer3D::lineMesh() const
+{
+    if (_sceneWindow) {
+        return _sceneWindow->lineMesh();
+    }
+    return _view->rootObject()->findChild<LineMesh *>(QStringLiteral("lineMesh"));
+}
+
+PositionTrace *Viewer3D::positionTrace() const
+{
+    if (_sceneWindow) {
+        return _sceneWindow->positionTrace();
+    }
+    return _view->rootObject()->findChild<PositionTrace *>(QStringLiteral("positionTrace"));
+}
+
 void Viewer3D::dropCatch(const QVariant &var)
 {
     emit droppedUrls(var.value<QList<QUrl> >());
@@ -63,7 +173,84 @@ void Viewer3D::dropCatch(const QVariant &var)
 
 void Viewer3D::drawModel(QString file)
 {
-    QObject *object = _view->rootObject();
-    QObject *fileName = object->findChild<QObject *>(QStringLiteral("fileName"));
+    _file = file;
+    LineMesh *mesh = lineMesh();
+    // Another file, the progress of a running print comes with its next update
+    if (mesh) {
+        mesh->setPrintProgress(-1);
+    }
+    PositionTrace *trace = positionTrace();
+    if (trace) {
+        trace->clear();
+    }
+    if (_sceneWindow) {
+        mesh->readAndRun(file);
+        return;
+    }
+    QObject *fileName = _view->rootObject()->findChild<QObject *>(QStringLiteral("fileName"));
     fileName->setProperty("text", QVariant(file));
 }
+
+QUrl Viewer3D::drawnFile() const
+{
+    return QUrl(_file);
+}
+
+void Viewer3D::setPrintProgress(const QUrl &file, float progress)
+{
+    LineMesh *mesh = lineMesh();
+    if (mesh && file == QUrl(_file)) {
+        mesh->setPrintProgress(progress);
+    }
+}
+
+void Viewer3D::addPrinterPosition(const QUrl &file, const QVector3D &position)
+{
+    LineMesh *mesh = lineMesh();
+    PositionTrace *trace = positionTrace();
+    if (!mesh || !trace || file != QUrl(_file)) {
+        return;
+    }
+    const QVector3D vertex = position / _mmPerUnit;
+    // Nothing to compare with until the file is loaded
+    const bool deviates = mesh->vertexCount() > 0 && !mesh->isOnToolpath(vertex, _deviationTolerance / _mmPerUnit);
+    trace->append(vertex, deviates);
+}
+
+void Viewer3D::setProfile(const QString &profile)
+{
+    if (!profile.isEmpty()) {
+        QSettings settings;
+        settings.beginGroup(QStringLiteral("Profiles"));
+        const bool known = settings.childGroups().contains(profile);
+        settings.endGroup();
+        if (!known) {
+            return;
+        }
+    }
+    _profile = profile;
+    updateMotionLimits();
+}
+
+void Viewer3D::updateMotionLimits()
+{
+    LineMesh *mesh = lineMesh();
+    if (!mesh) {
+        return;
+    }
+    if (_profile.isEmpty()) {
+        mesh->setMotionLimits(MotionLimits());
+        mesh->setBuildVolume(QVector3D());
+        return;
+    }
+    mesh->setMotionLimits(MotionLimits::fromProfile(_profile));
+
+    QSettings settings;
+    settings.beginGroup(QStringLiteral("Profiles"));
+    settings.beginGroup(_profile);
+    mesh->setBuildVolume(QVector3D(settings.value(QStringLiteral("dimensionX"), 0).toFloat(),
+                                   settings.value(QStringLiteral("dimensionY"), 0).toFloat(),
+                                   settings.value(QStringLiteral("dimensionZ"), 0).toFloat()));
+    settings.endGroup();
+    settings.endGroup();
+}
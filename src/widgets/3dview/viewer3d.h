@@ -23,10 +23,14 @@
 
 #include <QQuickView>
 #include <QQmlApplicationEngine>
+#include <QString>
+#include <QUrl>
+#include <QVector3D>
 #include <QWidget>
 
 class LineMesh;
-class QString;
+class PositionTrace;
+class SceneWindow;
 
 class Viewer3D : public QWidget
 {
@@ -36,15 +40,50 @@ public slots:
     void dropCatch(const QVariant &var);
 
 public:
+    enum Backend {
+        // QQuickView and Scene3D, with the QML controls
+        QuickBackend = 0,
+        // SceneWindow, the scene built in C++ without any control
+        WindowBackend
+    };
+    Q_ENUM(Backend)
+
+    // Uses the backend chosen last time
     explicit Viewer3D(QWidget *parent = nullptr);
+    explicit Viewer3D(Backend backend, QWidget *parent = nullptr);
     ~Viewer3D() override;
+    Backend backend() const;
+    // Builds the view again with another backend and remembers it, the drawn file is read again
+    void setBackend(Backend backend);
+    // Toolpath of the current backend
+    LineMesh *lineMesh() const;
     void drawModel(QString file);
+    QUrl drawnFile() const;
+    // Printer the print time is estimated for, unknown profiles are ignored.
+    // An empty profile goes back to the default limits and no build volume.
+    void setProfile(const QString &profile);
+    // Reads the limits and the build volume of the current profile again, after the profiles were edited
+    void updateMotionLimits();
+    // Shades the part of file already printed when it is the drawn one, progress is -1 once the print is over
+    void setPrintProgress(const QUrl &file, float progress);
+    // Adds a position reported by a printer to the trace when it prints the drawn file, position in mm
+    void addPrinterPosition(const QUrl &file, const QVector3D &position);
 
 private:
-    LineMesh *_lineMesh;
+    void createView();
+    PositionTrace *positionTrace() const;
+
     QQmlApplicationEngine _engine;
+    Backend _backend;
+    // Holds the window of the backend, only one of them exists
+    QWidget *_container;
     QQuickView *_view;
+    SceneWindow *_sceneWindow;
+    QString _profile;
+    QString _file;
 
 signals:
     void droppedUrls(QList<QUrl> fileList);
+    // A move of the drawn file was clicked, line is counted from 0
+    void lineClicked(const QUrl &file, int line);
 };
@@ -1,4 +1,5 @@
 import QtQuick 2.0
+import QtQuick.Controls 2.0
 import QtQuick.Scene3D 2.0
 import LineMesh 1.0
 
@@ -27,6 +28,8 @@ Item {
             cameraAspectRatioMode: Scene3D.AutomaticAspectRatio
             AnimatedEntity {
                 id: entity
+                viewportWidth: scene3d.width
+                viewportHeight: scene3d.height
                 onFpsChanged: {
                     // print(fps)
                 }
@@ -35,6 +38,135 @@ Item {
         }
     }
 
+    Text {
+        id: printTime
+        anchors.top: parent.top
+        anchors.right: parent.right
+        anchors.margins: 10
+        visible: entity.printTime > 0
+        text: i18n("Estimated print time: %1", formatTime(entity.printTime))
+
+        function formatTime(seconds) {
+            var total = Math.round(seconds)
+            var minutes = Math.floor(total / 60) % 60
+            return Math.floor(total / 3600) + ":" + (minutes < 10 ? "0" : "") + minutes
+        }
+    }
+
+    Column {
+        anchors.top: printTime.bottom
+        anchors.right: parent.right
+        anchors.margins: 10
+
+        CheckBox {
+            text: i18n("Extrusions")
+            checked: entity.showExtrusions
+            onCheckedChanged: entity.showExtrusions = checked
+        }
+
+        CheckBox {
+            text: i18n("Travels")
+            checked: entity.showTravels
+            onCheckedChanged: entity.showTravels = checked
+        }
+
+        CheckBox {
+            text: i18n("Ribbons")
+            checked: entity.showRibbons
+            onCheckedChanged: entity.showRibbons = checked
+        }
+
+        CheckBox {
+            text: i18n("Top, front and isometric views")
+            checked: entity.multiView
+            onCheckedChanged: entity.multiView = checked
+        }
+
+        ComboBox {
+            model: [i18n("Feature"), i18n("Speed"), i18n("Layer"), i18n("Flow")]
+            onCurrentIndexChanged: entity.colorScheme = ["feature", "speed", "layer", "flow"][currentIndex]
+        }
+
+        CheckBox {
+            id: simulation
+            text: i18n("Simulation")
+            enabled: entity.printTime > 0
+            onCheckedChanged: {
+                entity.playing = false
+                entity.playbackTime = checked ? 0 : -1
+            }
+        }
+
+        Row {
+            visible: simulation.checked
+            spacing: 5
+
+            Button {
+                text: entity.playing ? i18n("Pause") : i18n("Play")
+                onClicked: {
+                    // From the start again once the end is reached
+                    if (!entity.playing && entity.playbackTime >= entity.printTime) {
+                        entity.playbackTime = 0
+                    }
+                    entity.playing = !entity.playing
+                }
+            }
+
+            SpinBox {
+                from: 1
+                to: 1000
+                value: entity.playbackSpeed
+                onValueChanged: entity.playbackSpeed = value
+                textFromValue: function(value) { return value + "×" }
+            }
+        }
+
+        Slider {
+            visible: simulation.checked
+            from: 0
+            to: entity.printTime
+            value: Math.max(entity.playbackTime, 0)
+            // Scrubbing, the bound value follows the playback otherwise
+            onValueChanged: if (pressed) entity.playbackTime = value
+        }
+
+        Text {
+            visible: simulation.checked
+            text: printTime.formatTime(Math.max(entity.playbackTime, 0))
+        }
+    }
+
+    RangeSlider {
+        id: layerSlider
+        anchors.right: parent.right
+        anchors.verticalCenter: parent.verticalCenter
+        anchors.margins: 10
+        height: parent.height / 2
+        orientation: Qt.Vertical
+        visible: entity.layerCount > 1
+        from: 0
+        to: Math.max(entity.layerCount - 1, 0)
+        stepSize: 1
+        snapMode: RangeSlider.SnapAlways
+        first.value: 0
+        second.value: to
+        // Every layer of a new file is shown
+        onToChanged: {
+            first.value = 0
+            second.value = to
+        }
+        first.onValueChanged: entity.firstLayer = Math.round(first.value)
+        // -1 keeps following the end of the file
+        second.onValueChanged: entity.lastLayer = second.value >= to ? -1 : Math.round(second.value)
+    }
+
+    Text {
+        anchors.right: layerSlider.left
+        anchors.verticalCenter: layerSlider.verticalCenter
+        visible: layerSlider.visible
+        text: i18n("Layers %1–%2", Math.round(layerSlider.first.value) + 1, Math.round(layerSlider.second.value) + 1)
+    }
+
     Text {
         objectName: "fileName"
         id: fileName
@@ -20,6 +20,7 @@
 #include <GCodeCommands>
 #include <KLocalizedString>
 #include <SerialLayer>
+#include <QRegularExpression>
 #include <QToolBar>
 #include "atcoreinstancewidget.h"
 
@@ -28,6 +29,7 @@ AtCoreInstanceWidget::AtCoreInstanceWidget(QWidget *parent):
     , m_fileCount(0)
     , m_printAction(nullptr)
     , m_stopAction(nullptr)
+    , m_tracePositionAction(nullptr)
     , m_toolBar(nullptr)
 {
     m_theme = palette().text().color().value() >= QColor(Qt::lightGray).value() ? QString("dark") : QString("light") ;
@@ -156,6 +158,21 @@ void AtCoreInstanceWidget::buildToolbar()
     connect(disableMotorsAction, &QAction::triggered, this, &AtCoreInstanceWidget::disableMotors);
     m_toolBar->addAction(disableMotorsAction);
 
+    m_toolBar->addSeparator();
+
+    m_tracePositionAction = new QAction(i18n("Trace Position"));
+    m_tracePositionAction->setCheckable(true);
+    m_tracePositionAction->setChecked(m_settings.value(QStringLiteral("tracePosition"), false).toBool());
+    m_tracePositionAction->setToolTip(i18n("Draw the positions reported by the printer next to the printed file.\n"
+                                           "Firmwares that cannot report the position on their own are asked for it with M114 every second, "
+                                           "which makes some of them pause the print."));
+    connect(m_tracePositionAction, &QAction::toggled, this, [this](bool checked) {
+        m_settings.setValue(QStringLiteral("tracePosition"), checked);
+        const AtCore::STATES state = m_core.state();
+        tracePosition(checked && !m_printFile.isEmpty() && (state == AtCore::STARTPRINT || state == AtCore::BUSY || state == AtCore::PAUSE));
+    });
+    m_toolBar->addAction(m_tracePositionAction);
+
     togglePrintButtons(m_fileCount);
 }
 
@@ -221,6 +238,7 @@ void AtCoreInstanceWidget::connectButtonClicked()
                 m_core.loadFirmwarePlugin(fw);
             }
             emit(connectionChanged(m_profileData["name"].toString()));
+            emit profileChanged(m_profileData["name"].toString());
             m_profileData["heatedBed"].toBool() ? m_bedExtWidget->setBedMaxTemperature(m_profileData["bedTemp"].toInt()) :
             m_bedExtWidget->setBedThermoHidden(true);
 
@@ -239,6 +257,12 @@ void AtCoreInstanceWidget::initConnectsToAtCore()
     //connect log to atcoreMessages
     connect(&m_core, &AtCore::atcoreMessage, m_logWidget, &LogWidget::appendLog);
     m_core.setSerialTimerInterval(100);
+    m_positionTimer.setInterval(1000);
+    connect(&m_positionTimer, &QTimer::timeout, this, [this] {
+        if (!m_lastPositionReport.isValid() || m_lastPositionReport.elapsed() > m_positionTimer.interval()) {
+            m_core.pushCommand(GCode::toCommand(GCode::M114));
+        }
+    });
     // Handle device changes
     connect(&m_core, &AtCore::portsChanged, this, &AtCoreInstanceWidget::updateSerialPort);
     // Handle AtCore status change
@@ -288,6 +312,7 @@ void AtCoreInstanceWidget::initConnectsToAtCore()
                 , i18n("You must Select a file from the list")
             );
         } else  {
+            m_printFile.clear();
             m_core.print(fileName, true);
             togglePrintButtons(true);
         }
@@ -310,6 +335,7 @@ void AtCoreInstanceWidget::printFile(const QUrl &fileName)
 {
     if (!fileName.isEmpty() && (m_core.state() == AtCore::IDLE)) {
         m_logWidget->appendLog(i18n("Printing:%1", fileName.toLocalFile()));
+        m_printFile = fileName;
         m_core.print(fileName.toLocalFile());
     }
 }
@@ -352,8 +378,16 @@ void AtCoreInstanceWidget::handlePrinterStatusChanged(AtCore::STATES newState)
         m_logWidget->appendLog(i18n("Attempting to Connect"));
         connect(&m_core, &AtCore::receivedMessage, m_logWidget, &LogWidget::appendRLog);
         connect(m_core.serial(), &SerialLayer::pushedCommand, m_logWidget, &LogWidget::appendSLog);
+        connect(&m_core, &AtCore::receivedMessage, this, &AtCoreInstanceWidget::checkCapabilities, Qt::UniqueConnection);
+        m_autoReportPosition = false;
+        m_capabilitiesRequested = false;
     } break;
     case AtCore::IDLE: {
+        // The firmware tells what it can do in its M115 answer
+        if (!m_capabilitiesRequested) {
+            m_capabilitiesRequested = true;
+            m_core.pushCommand(GCode::toCommand(GCode::M115));
+        }
         stateString = i18n("Connected to %1", m_core.serial()->portName());
         emit extruderCountChanged(m_core.extruderCount());
         m_logWidget->appendLog(stateString);
@@ -366,6 +400,9 @@ void AtCoreInstanceWidget::handlePrinterStatusChanged(AtCore::STATES newState)
     } break;
     case AtCore::DISCONNECTED: {
         stateString = i18n("Not Connected");
+        tracePosition(false);
+        disconnect(&m_core, &AtCore::receivedMessage, this, &AtCoreInstanceWidget::checkCapabilities);
+        emit profileChanged(QString());
         disconnect(&m_core, &AtCore::receivedMessage, m_logWidget, &LogWidget::appendRLog);
         disconnect(m_core.serial(), &SerialLayer::pushedCommand, m_logWidget, &LogWidget::appendSLog);
         m_logWidget->appendLog(i18n("Serial disconnected"));
@@ -383,12 +420,17 @@ void AtCoreInstanceWidget::handlePrinterStatusChanged(AtCore::STATES newState)
     case AtCore::STARTPRINT: {
         stateString = i18n("Starting Print");
         m_statusWidget->showPrintArea(true);
-        connect(&m_core, &AtCore::printProgressChanged, m_statusWidget, &StatusWidget::updatePrintProgress);
+        connect(&m_core, &AtCore::printProgressChanged, m_statusWidget, &StatusWidget::updatePrintProgress, Qt::UniqueConnection);
+        connect(&m_core, &AtCore::printProgressChanged, this, &AtCoreInstanceWidget::updatePrintProgress, Qt::UniqueConnection);
+        tracePosition(m_tracePositionAction->isChecked() && !m_printFile.isEmpty());
     } break;
     case AtCore::FINISHEDPRINT: {
         stateString = i18n("Finished Print");
         m_statusWidget->showPrintArea(false);
         disconnect(&m_core, &AtCore::printProgressChanged, m_statusWidget, &StatusWidget::updatePrintProgress);
+        disconnect(&m_core, &AtCore::printProgressChanged, this, &AtCoreInstanceWidget::updatePrintProgress);
+        updatePrintProgress(-1);
+        tracePosition(false);
         m_printAction->setText(i18n("Print"));
         m_printAction->setIcon(QIcon::fromTheme("media-playback-start", QIcon(QString(":/%1/start").arg(m_theme))));
         m_logWidget->appendLog(i18n("Finished Print Job"));
@@ -406,10 +448,18 @@ void AtCoreInstanceWidget::handlePrinterStatusChanged(AtCore::STATES newState)
     } break;
     case AtCore::STOP: {
         stateString = i18n("Stoping Print");
+        disconnect(&m_core, &AtCore::printProgressChanged, m_statusWidget, &StatusWidget::updatePrintProgress);
+        disconnect(&m_core, &AtCore::printProgressChanged, this, &AtCoreInstanceWidget::updatePrintProgress);
+        updatePrintProgress(-1);
+        tracePosition(false);
         m_logWidget->appendLog(stateString);
     } break;
     case AtCore::ERRORSTATE: {
         stateString = i18n("Error");
+        disconnect(&m_core, &AtCore::printProgressChanged, m_statusWidget, &StatusWidget::updatePrintProgress);
+        disconnect(&m_core, &AtCore::printProgressChanged, this, &AtCoreInstanceWidget::updatePrintProgress);
+        updatePrintProgress(-1);
+        tracePosition(false);
     } break;
     default:
         m_logWidget->appendLog(i18n("Unknown AtCore State, %1", newState));
@@ -482,6 +532,52 @@ void AtCoreInstanceWidget::setFileCount(int count)
     togglePrintButtons(m_fileCount);
 }
 
+void AtCoreInstanceWidget::updatePrintProgress(float progress)
+{
+    if (!m_printFile.isEmpty()) {
+        emit printProgressChanged(m_printFile, progress);
+    }
+}
+
+void AtCoreInstanceWidget::tracePosition(bool trace)
+{
+    if (trace == m_positionTimer.isActive()) {
+        return;
+    }
+    // Firmwares that can report the position on their own do it every second, the others are polled with M114
+    if (m_autoReportPosition && m_core.state() != AtCore::DISCONNECTED) {
+        m_core.pushCommand(trace ? QStringLiteral("M154 S1") : QStringLiteral("M154 S0"));
+    }
+    m_lastPositionReport.invalidate();
+    if (trace) {
+        connect(&m_core, &AtCore::receivedMessage, this, &AtCoreInstanceWidget::checkPositionReport);
+        m_positionTimer.start();
+    } else {
+        disconnect(&m_core, &AtCore::receivedMessage, this, &AtCoreInstanceWidget::checkPositionReport);
+        m_positionTimer.stop();
+    }
+}
+
+void AtCoreInstanceWidget::checkCapabilities(const QByteArray &message)
+{
+    // Marlin 2.0.9 and later built with AUTO_REPORT_POSITION
+    if (message.startsWith("Cap:AUTOREPORT_POS:")) {
+        m_autoReportPosition = message.trimmed().endsWith(":1");
+    }
+}
+
+void AtCoreInstanceWidget::checkPositionReport(const QByteArray &message)
+{
+    // M114 answers and auto-reports: "X:10.00 Y:20.00 Z:0.30 E:5.00 Count X:..."
+    static const QRegularExpression report(QStringLiteral("^X:(-?\\d+\\.?\\d*) Y:(-?\\d+\\.?\\d*) Z:(-?\\d+\\.?\\d*)"));
+    const QRegularExpressionMatch match = report.match(QString::fromLatin1(message));
+    if (!match.hasMatch()) {
+        return;
+    }
+    m_lastPositionReport.start();
+    emit positionReported(m_printFile, QVector3D(match.captured(1).toFloat(), match.captured(2).toFloat(), match.captured(3).toFloat()));
+}
+
 void AtCoreInstanceWidget::updateSerialPort(QStringList ports)
 {
     m_comboPort->clear();
@@ -27,11 +27,14 @@
 #include <SdWidget>
 #include <StatusWidget>
 #include <QComboBox>
+#include <QElapsedTimer>
 #include <QList>
 #include <QPushButton>
 #include <QSettings>
+#include <QTimer>
 #include <QToolBar>
 #include <QUrl>
+#include <QVector3D>
 #include <QWidget>
 #include "bedextruderwidget.h"
 
@@ -67,6 +70,8 @@ private:
     StatusWidget *m_statusWidget;
     QAction *m_printAction;
     QAction *m_stopAction;
+    // Off by default, polling the position pauses the print on some firmwares
+    QAction *m_tracePositionAction;
     QComboBox *m_comboPort;
     QComboBox *m_comboProfile;
     QMap<QString, QVariant> m_profileData;
@@ -76,6 +81,14 @@ private:
     QTabWidget *m_tabWidget;
     QToolBar *m_connectToolBar;
     QToolBar *m_toolBar;
+    // Local file being printed, empty for SD prints
+    QUrl m_printFile;
+    // Polls the position while printing, unless the firmware reported it lately
+    QTimer m_positionTimer;
+    QElapsedTimer m_lastPositionReport;
+    // From the M115 answer, M154 is only sent when the firmware supports it
+    bool m_autoReportPosition = false;
+    bool m_capabilitiesRequested = false;
     QWidget *m_advancedTab;
     QWidget *m_connectWidget;
     void buildConnectionToolbar();
@@ -92,13 +105,23 @@ private:
     QMap<QString, QVariant> readProfile();
     void pausePrint();
     void print();
+    void updatePrintProgress(float progress);
+    void checkCapabilities(const QByteArray &message);
+    void checkPositionReport(const QByteArray &message);
+    void tracePosition(bool trace);
     void updateSerialPort(QStringList ports);
     void togglePrintButtons(bool shown);
 
 signals:
     void connectionChanged(QString name);
+    // Profile of the connected printer, empty once it is disconnected
+    void profileChanged(const QString &profile);
     void disableDisconnect(bool b);
     void extruderCountChanged(int count);
     void requestProfileDialog();
     void requestFileChooser();
+    // Percent of the file sent to the printer, -1 once the print is over
+    void printProgressChanged(const QUrl &file, float progress);
+    // Position of the head while file is printed, in mm
+    void positionReported(const QUrl &file, const QVector3D &position);
 };
@@ -17,6 +17,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <KLocalizedString>
+#include <KTextEditor/Cursor>
 #include <QLabel>
 #include <QVBoxLayout>
 #include "gcodeeditorwidget.h"
@@ -62,6 +63,17 @@ void GCodeEditorWidget::loadFile(const QUrl &file)
     m_tabwidget->setCurrentIndex(t);
 }
 
+void GCodeEditorWidget::goToLine(const QUrl &file, int line)
+{
+    auto view = qobject_cast<KTextEditor::View *>(urlTab.value(file));
+    if (!view) {
+        return;
+    }
+    m_tabwidget->setCurrentWidget(view);
+    view->setCursorPosition(KTextEditor::Cursor(line, 0));
+    view->setFocus();
+}
+
 void GCodeEditorWidget::setupInterface(const KTextEditor::View *view)
 {
     m_interface = qobject_cast<KTextEditor::ConfigInterface *>(view);
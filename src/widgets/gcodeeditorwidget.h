@@ -32,6 +32,8 @@ class GCodeEditorWidget : public QWidget
 public:
     explicit GCodeEditorWidget(QWidget *parent = nullptr);
     void loadFile(const QUrl &file);
+    // Shows the tab of an open file with the cursor on line, counted from 0
+    void goToLine(const QUrl &file, int line);
 
 private:
     QMap<QUrl, KTextEditor::Document *> urlDoc;